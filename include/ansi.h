@@ -0,0 +1,65 @@
+#ifndef ANSI_H
+#define ANSI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Raw ANSI terminal backend: no ncurses, no terminfo. Drawing calls only
+update an in-memory grid of cells; ansi_refresh() compares the dirty rows
+with what is already on the terminal, builds the cursor moves and SGR
+colours for the changed cells into one buffer and emits it with a single
+write(). The same buffer can be appended to an asciicast v2 file (one event
+per refresh), which `asciinema play` replays. */
+
+#define ANSI_RENDER_ENV "PACMAN_RENDER"      // "ansi" seleciona este backend no cliente
+#define ANSI_CAST_ENV "PACMAN_RENDER_CAST"   // Ficheiro .cast onde gravar os frames
+
+// Atributos de uma célula: par de cor 1..7 (como em init_pair) mais flags
+#define ANSI_COLOUR_MASK 0x07
+#define ANSI_BOLD 0x08
+#define ANSI_DIM 0x10
+
+typedef struct {
+    char ch;
+    uint8_t attr;
+} ansi_cell_t;
+
+typedef struct {
+    int fd;                            // Terminal (ou -1 para só gravar)
+    int cast_fd;                       // Ficheiro asciicast (-1 = sem gravação)
+    int cast_started;                  // Cabeçalho do .cast já escrito
+    uint64_t cast_epoch_us;
+    int rows, cols;                    // Tamanho das grelhas
+    ansi_cell_t* cells;                // Ecrã pretendido
+    ansi_cell_t* shown;                // O que o terminal mostra
+    unsigned char* dirty;              // Linhas alteradas desde o último refresh
+    int full;                          // 1 = limpar o terminal e redesenhar tudo
+    char* out;                         // Sequências do próximo write()
+    size_t out_len, out_cap;
+    int cur_row, cur_col;              // Posição do cursor do terminal (-1 = desconhecida)
+    int cur_attr;                      // SGR ativo (-1 = desconhecido)
+} ansi_screen_t;
+
+/*Prepares a screen writing to fd (-1 for none) and, if cast_path is not
+NULL, recording to that asciicast file. Returns 0 on success*/
+int ansi_init(ansi_screen_t* screen, int fd, const char* cast_path);
+
+/*Restores the cursor and colours and frees the screen*/
+void ansi_end(ansi_screen_t* screen);
+
+/*Blanks the whole screen (the terminal is cleared on the next refresh)*/
+void ansi_clear(ansi_screen_t* screen);
+
+/*Blanks a row from col to the end*/
+void ansi_clear_line(ansi_screen_t* screen, int row, int col);
+
+void ansi_put(ansi_screen_t* screen, int row, int col, char ch, int attr);
+
+void ansi_print(ansi_screen_t* screen, int row, int col, int attr, const char* format, ...)
+    __attribute__((format(printf, 5, 6)));
+
+/*Emits every change since the last refresh with one write(). Returns the
+number of bytes written to the terminal*/
+size_t ansi_refresh(ansi_screen_t* screen);
+
+#endif
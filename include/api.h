@@ -1,23 +1,125 @@
 #ifndef API_H
 #define API_H
 
+#include <stddef.h>
+
 typedef struct {
   int width;
   int height;
   int tempo;
-  int victory;
-  int game_over;
+  int victory;            // Nível passado (o seguinte chega nos próximos frames)
+  int game_over;          // Fim do jogo: último frame antes de pacman_new_game()
   int accumulated_points;
   char* data;
+  int has_seq;            // 1 = frame OP_CODE_BOARD_SEQ (campos abaixo válidos)
+  unsigned int last_seq;  // Última jogada de pacman_play_seq() aplicada (0 = nenhuma)
+  unsigned int tick;      // Ticks de ghosts já executados pelo servidor
 } Board;
 
+/// Receive state for receive_board_latest(): two buffers that frames are
+/// read into and decoded in place (Board.data points into them).
+typedef struct {
+  char* buf[2];
+  size_t capacity[2];
+  int front;              // Buffer do último frame devolvido
+  size_t start;           // Bytes por consumir em buf[front]: [start, end)
+  size_t end;
+  int eof;                // O servidor fechou o pipe
+  Board board;            // Último frame devolvido
+  unsigned long frames;   // Frames recebidos
+  unsigned long skipped;  // Frames descartados por haver um mais recente
+} BoardReceiver;
+
+/// One connection to the server. The functions below without "session" in
+/// their name drive a single global connection with blocking calls; a
+/// pacman_session_t is a separate connection (any number per process) whose
+/// calls never wait for the server. Poll pacman_session_fd() for POLLIN and
+/// call pacman_try_receive() until it returns PACMAN_EVENT_NONE.
+typedef struct pacman_session pacman_session_t;
+
+typedef enum {
+  PACMAN_EVENT_NONE = 0,  // Nada completo por ler: esperar pelo fd
+  PACMAN_EVENT_CONNECTED, // O servidor aceitou o CONNECT
+  PACMAN_EVENT_FRAME,     // *board aponta para o próximo frame
+  PACMAN_EVENT_CLOSED,    // O servidor fechou, rejeitou a ligação ou enviou dados inválidos
+} pacman_event_t;
+
 int pacman_connect(char const *req_pipe_path, char const *notif_pipe_path, char const *server_pipe_path);
 
 void pacman_play(char command);
 
+/// Sends command tagged with a new sequence number; frames sent after it is
+/// applied carry that number in Board.last_seq.
+/// @return the sequence number used (starting at 1), or 0 if it was not sent.
+unsigned int pacman_play_seq(char command);
+
+/// Sends n commands as PLAY_SEQ messages with consecutive sequence numbers,
+/// built into one buffer and written with a single write() (one per
+/// PIPE_BUF bytes, so each chunk reaches the server intact).
+/// @return the sequence number of the first command (the last is first + n - 1),
+/// or 0 if n is 0 or the write failed.
+unsigned int pacman_play_batch(const char* cmds, size_t n);
+
+/// After a frame with game_over, asks for another game on the
+/// same connection instead of disconnecting: no new FIFOs, CONNECT or queue
+/// slot. Frames received after it belong to the new game.
+/// @param mode NEW_GAME_RESTART (first level, points reset) or
+/// NEW_GAME_NEXT_LEVEL (level after the last one played, points kept;
+/// wraps to the first level), from protocol.h.
+/// @return 0 on success, -1 if it could not be sent.
+int pacman_new_game(int mode);
+
+/// Sends DISCONNECT and closes the request pipe. The notification pipe stays
+/// open, so a thread blocked in receive_board_update() or
+/// receive_board_latest() returns normally once the server closes it.
 /// @return 0 if the disconnection was successful, 1 otherwise.
 int pacman_disconnect();
 
+/// Closes the notification pipe, removes the FIFOs and frees the session.
+/// Call it after pacman_disconnect(), once no thread is receiving frames.
+void pacman_close(void);
+
 Board receive_board_update(void);
 
+/// Creates the session FIFOs and sends CONNECT without waiting for the
+/// reply (PACMAN_EVENT_CONNECTED reports it).
+/// @return the new session, or NULL on failure.
+pacman_session_t* pacman_session_open(char const *req_pipe_path, char const *notif_pipe_path,
+                                      char const *server_pipe_path);
+
+/// @return the notification fd to watch for POLLIN (poll/epoll).
+int pacman_session_fd(const pacman_session_t* session);
+
+/// Reads whatever the server has sent without blocking and returns the next
+/// event. For PACMAN_EVENT_FRAME, *board (and its data) stays valid until the
+/// next call on this session. board may be NULL while connecting.
+pacman_event_t pacman_try_receive(pacman_session_t* session, const Board** board);
+
+/// @return 0 on success, -1 if the command could not be sent.
+int pacman_session_play(pacman_session_t* session, char command);
+
+unsigned int pacman_session_play_seq(pacman_session_t* session, char command);
+
+unsigned int pacman_session_play_batch(pacman_session_t* session, const char* cmds, size_t n);
+
+int pacman_session_new_game(pacman_session_t* session, int mode);
+
+/// Sends DISCONNECT and closes the request pipe; frames already on the way
+/// can still be received until PACMAN_EVENT_CLOSED.
+/// @return 0 if the disconnection was successful, 1 otherwise.
+int pacman_session_disconnect(pacman_session_t* session);
+
+/// Disconnects if still playing, closes and removes the FIFOs and frees the session.
+void pacman_session_close(pacman_session_t* session);
+
+void board_receiver_init(BoardReceiver* receiver);
+
+void board_receiver_free(BoardReceiver* receiver);
+
+/// Blocks until a frame arrives, then also decodes every frame already
+/// queued in the pipe and returns only the newest. No allocation once the
+/// buffers fit a frame. The Board (and its data) stays valid until the next
+/// call returns. On disconnection, game_over is 1 and data is NULL.
+const Board* receive_board_latest(BoardReceiver* receiver);
+
 #endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef BOARD_H
 #define BOARD_H
 
+#include "rng.h"
+
 #define MAX_MOVES 20
 #define MAX_LEVELS 20
 #define MAX_FILENAME 256
@@ -58,6 +60,8 @@ typedef struct {
     char pacman_file[256];  // file with pacman movements
     char ghosts_files[MAX_GHOSTS][256]; // files with monster movements
     int tempo;              // Duration of each play
+    uint64_t seed;          // seed used for 'R' commands in this game
+    rng_t rng;              // per-board generator for 'R' commands (no shared rand() state)
 } board_t;
 
 // Estrutura para guardar dados parseados do ficheiro .lvl
@@ -98,15 +102,19 @@ int load_level(board_t* board, int accumulated_points, level_data_t* level_data,
 /*Unloads levels loaded by load_level*/
 void unload_level(board_t * board);
 
+/*Makes dst (a board loaded by load_level) an exact copy of src, reusing
+dst's arrays when the sizes match. Returns 0 on success*/
+int copy_level(board_t* dst, const board_t* src);
+
 // DEBUG FILE
 
-/*Opens the debug file*/
+/*Opens the debug file (binary, asynchronous; see log.h and bin/logdecode)*/
 void open_debug_file(char *filename);
 
 /*Closes the debug file*/
 void close_debug_file();
 
-/*Writes to the open debug file*/
+/*Queues a DEBUG record for the debug file. format must be a string literal*/
 void debug(const char * format, ...);
 
 /*Writes the board and its contents to the open debug file*/
@@ -0,0 +1,75 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <pthread.h>
+#include <time.h>
+
+#define CLOCK_HIST_BUCKETS 16          // Histogramas log2: bucket i = [2^(i-1), 2^i)
+#define CLOCK_MAX_CATCHUP 3            // Ticks em atraso recuperados de seguida antes de ressincronizar
+#define CLOCK_DEFAULT_PERIOD_MS 50     // Período usado quando o nível tem TEMPO 0
+
+// Estatísticas de um relógio de ticks
+typedef struct {
+    unsigned long ticks;                            // Ticks servidos
+    unsigned long overruns;                         // Ticks que começaram depois do prazo do seguinte
+    unsigned long resyncs;                          // Vezes que o atraso excedeu max_catchup
+    long max_jitter_us;                             // Maior atraso de início observado
+    unsigned long jitter_hist[CLOCK_HIST_BUCKETS];  // Atraso do início do tick face ao prazo (µs)
+    unsigned long overrun_hist[CLOCK_HIST_BUCKETS]; // Períodos inteiros perdidos em cada ultrapassagem
+} tick_stats_t;
+
+// Relógio de prazos absolutos: o tick n começa em epoch + n * period
+typedef struct {
+    struct timespec epoch;             // Instante do tick 0 (CLOCK_MONOTONIC)
+    long period_ns;                    // Duração de um tick
+    unsigned long tick;                // Próximo tick a servir
+    int max_catchup;                   // Atraso máximo (em ticks) recuperado sem ressincronizar
+    tick_stats_t stats;
+} tick_clock_t;
+
+// Permite acordar antes do prazo uma thread a dormir num tick_clock
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;               // Em CLOCK_MONOTONIC, o relógio dos prazos
+    unsigned long wakeups;             // Incrementado por cada tick_wake_signal()
+} tick_wake_t;
+
+#define TICK_CLOCK_WOKEN ((unsigned long)-1)  // tick_clock_wait_wake() acordada antes do prazo
+
+/*Starts a clock whose tick 0 is at epoch (NULL = now). period_ms <= 0 uses CLOCK_DEFAULT_PERIOD_MS*/
+void tick_clock_init(tick_clock_t* clock, const struct timespec* epoch, int period_ms, int max_catchup);
+
+/*Sleeps until the next tick's absolute deadline and returns its number.
+Late ticks up to max_catchup periods run back-to-back; beyond that the
+schedule is shifted so the game slows down instead of bursting*/
+unsigned long tick_clock_wait(tick_clock_t* clock);
+
+/*Makes the next tick_clock_wait() serve tick (no-op if tick is already past).
+Lets a thread sleep straight to the next tick where something happens*/
+void tick_clock_skip_to(tick_clock_t* clock, unsigned long tick);
+
+int tick_wake_init(tick_wake_t* wake);
+
+void tick_wake_destroy(tick_wake_t* wake);
+
+/*Number of wakeups so far. Read it before checking the state that a wakeup
+announces and pass it to the wait, so a wakeup in between is not lost*/
+unsigned long tick_wake_seen(tick_wake_t* wake);
+
+/*Ends every wait on wake that started from an older tick_wake_seen() value*/
+void tick_wake_signal(tick_wake_t* wake);
+
+/*Sleeps until tick_wake_signal() is called after seen was read*/
+void tick_wake_wait(tick_wake_t* wake, unsigned long seen);
+
+/*Like tick_clock_wait(), but returns TICK_CLOCK_WOKEN without serving the
+tick if tick_wake_signal() is called after seen was read*/
+unsigned long tick_clock_wait_wake(tick_clock_t* clock, tick_wake_t* wake, unsigned long seen);
+
+/*Adds the counters and histograms of from into into*/
+void tick_stats_merge(tick_stats_t* into, const tick_stats_t* from);
+
+/*Writes the statistics to the debug file*/
+void tick_stats_log(const char* label, const tick_stats_t* stats);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include "board.h"
+
+// Cabeçalho de OP_CODE_BOARD: op (1) + width, height, tempo, victory, game_over, points (6*4)
+#define FRAME_HEADER_SIZE 25
+// Cabeçalho de OP_CODE_BOARD_SEQ: o anterior + última seq aplicada e tick (2*4)
+#define FRAME_SEQ_HEADER_SIZE 33
+
+/*Size in bytes of the OP_CODE_BOARD message for board*/
+int frame_size(board_t* board);
+
+/*Size in bytes of the OP_CODE_BOARD_SEQ message for board*/
+int frame_seq_size(board_t* board);
+
+/*Serializes board into out (at least frame_size(board) bytes), returns bytes written*/
+int encode_board_frame(board_t* board, int victory, int game_over, char* out);
+
+/*Like encode_board_frame, as OP_CODE_BOARD_SEQ carrying the sequence number of
+the last PLAY_SEQ applied and the number of ghost ticks run so far
+(out needs frame_seq_size(board) bytes)*/
+int encode_board_frame_seq(board_t* board, int victory, int game_over, unsigned int last_seq,
+                           unsigned int tick, char* out);
+
+#endif
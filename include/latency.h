@@ -0,0 +1,33 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+/* Log-linear histogram (HDR style): values below 2^LATENCY_SUB_BITS are
+exact, above that each power of two is split into 2^LATENCY_SUB_BITS linear
+sub-buckets, so every bucket is within ~6% of the values it holds */
+#define LATENCY_SUB_BITS 4
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_MAX_EXP 31                 // Valores até 2^32 - 1 µs
+#define LATENCY_BUCKETS ((LATENCY_MAX_EXP - LATENCY_SUB_BITS + 2) * LATENCY_SUB_BUCKETS)
+
+typedef struct {
+    unsigned long counts[LATENCY_BUCKETS];
+    unsigned long total;
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;
+} latency_hist_t;
+
+void latency_init(latency_hist_t* hist);
+
+/*Adds one sample (values above 2^32 - 1 are clamped)*/
+void latency_record(latency_hist_t* hist, uint64_t value);
+
+/*Upper bound of the bucket holding the given percentile (0..100), 0 if empty*/
+uint64_t latency_percentile(latency_hist_t* hist, double percentile);
+
+/*Writes the summary and the non-empty buckets to the debug file*/
+void latency_log(latency_hist_t* hist, const char* label);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <stdint.h>
+
+#define LEADERBOARD_LOG_PATH "scores.log"
+#define LEADERBOARD_INDEX_PATH "scores.idx"
+#define LEADERBOARD_BATCH_MS 200       // Janela de agrupamento antes de escrever e fazer fsync
+#define LEADERBOARD_BATCH_MAX 256      // Escreve mais cedo se a janela juntar tantos jogos
+#define LEADERBOARD_MAX_LEVELS 32      // Níveis distintos listados por leaderboard_levels
+#define LEADERBOARD_INDEX_MAGIC "PMSI"
+#define LEADERBOARD_INDEX_VERSION 2
+
+/* Durable all-time scores. Finished games are queued in memory by the
+session manager and appended by a background thread to scores.log
+(fixed-size records, one fdatasync per batch). scores.idx is a memory-mapped
+copy of every record sorted by level and then by points, merged with each
+batch, so the top of a level is a binary search plus a short scan instead
+of a pass over the log. The index is derived
+data: a missing, stale or half-merged index is rebuilt from the log when the
+server starts. */
+
+// Um jogo terminado (registo do log e entrada do índice, 64 bytes)
+typedef struct {
+    uint64_t timestamp;                // CLOCK_REALTIME em ns no fim do jogo
+    int32_t client_id;
+    int32_t points;
+    uint32_t ticks;
+    uint8_t outcome;                   // replay_outcome_t
+    uint8_t reserved[11];
+    char level[32];                    // Nome do nível (sem .lvl)
+} score_record_t;
+
+// Cabeçalho de scores.idx, seguido de count registos por nível e, em cada nível, por ordem decrescente de pontos
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t count;                    // Registos do log já fundidos (os primeiros count)
+    uint32_t dirty;                    // 1 durante uma fusão: no arranque obriga a reconstruir
+    uint8_t reserved[44];
+} score_index_header_t;
+
+/*Opens (creating if needed) the score log and index, recovers the index
+from the log, and starts the writer thread. Returns 0 on success*/
+int leaderboard_open(const char* log_path, const char* index_path);
+
+/*Writes every queued game, stops the writer thread and unmaps the index*/
+void leaderboard_close(void);
+
+/*Queues a finished game. Never touches the disk: safe from session threads*/
+void leaderboard_submit(int client_id, const char* level, int points, unsigned int ticks, int outcome);
+
+/*Copies up to n best games into out, all-time (level NULL) or on one level.
+Queued games that are not written yet are not included. Returns the count*/
+int leaderboard_top(const char* level, score_record_t* out, int n);
+
+/*Copies up to max distinct level names found in the index into names.
+Returns the count*/
+int leaderboard_levels(char names[][32], int max);
+
+#endif
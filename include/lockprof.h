@@ -0,0 +1,65 @@
+#ifndef LOCKPROF_H
+#define LOCKPROF_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+/* Opt-in lock contention profiler (make LOCK_PROFILING=1). Every lock,
+unlock and condition wait on a profiled mutex goes through the prof_*
+macros, which record per call site: acquisitions, how many found the mutex
+taken, time spent waiting, time held, and how long other threads waited
+while this site held it. In normal builds the macros are the plain pthread
+calls and the profile fields do not exist. */
+
+#define LOCKPROF_MAX_SITES 24          // Slots por mutex: MAX-1 locais distintos e um "(other)" para os excedentes
+#define LOCKPROF_TOP_SITES 5           // Locais mostrados por relatório
+
+// Estatísticas de um local de chamada (atualizadas só por quem tem o mutex)
+typedef struct {
+    const char* func;
+    int line;
+    unsigned long acquisitions;
+    unsigned long contended;           // Aquisições que encontraram o mutex ocupado
+    uint64_t wait_ns;
+    uint64_t max_wait_ns;
+    uint64_t hold_ns;
+    uint64_t max_hold_ns;
+    uint64_t blocking_ns;              // Espera de outras threads enquanto este local tinha o mutex
+} lock_site_t;
+
+typedef struct {
+    lock_site_t sites[LOCKPROF_MAX_SITES];
+    int n_sites;                       // Locais distintos registados (no máximo LOCKPROF_MAX_SITES - 1)
+    lock_site_t* holder;               // Local com o mutex (NULL = livre); lido sem o mutex por quem espera
+    uint64_t locked_at;
+} lock_profile_t;
+
+void lockprof_init(lock_profile_t* profile);
+
+void lockprof_lock(pthread_mutex_t* mutex, lock_profile_t* profile, const char* func, int line);
+
+void lockprof_unlock(pthread_mutex_t* mutex, lock_profile_t* profile);
+
+/*pthread_cond_wait on a profiled mutex: the wait releases the mutex, so the
+hold time is closed before it and a new acquisition opened after it*/
+int lockprof_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex, lock_profile_t* profile,
+                       const char* func, int line);
+
+/*Logs the LOCKPROF_TOP_SITES sites with the most wait caused plus suffered,
+taking mutex to read a consistent copy*/
+void lockprof_report(lock_profile_t* profile, pthread_mutex_t* mutex, const char* label);
+
+#ifdef LOCK_PROFILING
+#define prof_lock(mutex, profile) lockprof_lock((mutex), (profile), __func__, __LINE__)
+#define prof_unlock(mutex, profile) lockprof_unlock((mutex), (profile))
+#define prof_cond_wait(cond, mutex, profile) lockprof_cond_wait((cond), (mutex), (profile), __func__, __LINE__)
+#define prof_report(profile, mutex, label) lockprof_report((profile), (mutex), (label))
+#else
+// O argumento profile é descartado sem ser avaliado: os campos só existem com LOCK_PROFILING
+#define prof_lock(mutex, profile) pthread_mutex_lock(mutex)
+#define prof_unlock(mutex, profile) pthread_mutex_unlock(mutex)
+#define prof_cond_wait(cond, mutex, profile) pthread_cond_wait((cond), (mutex))
+#define prof_report(profile, mutex, label) ((void)0)
+#endif
+
+#endif
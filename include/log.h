@@ -0,0 +1,90 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdarg.h>
+#include <stdint.h>
+
+/* Asynchronous binary logger. A log call copies the format pointer and the
+raw arguments into a lock-free ring owned by the calling thread (no locks, no
+syscalls, no formatting); a background thread moves the records to the log
+file, which bin/logdecode turns back into text. Formats must be string
+literals: only their address is recorded. */
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+
+// Chamadas abaixo deste nível são removidas pelo compilador (make LOG_MIN_LEVEL=2)
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_MAGIC "PMLG"
+#define LOG_VERSION 1
+#define LOG_RING_BYTES (64 * 1024)     // Anel por thread; registos que não cabem são contados e descartados
+#define LOG_MAX_RECORD 512             // Tamanho máximo de um registo (argumentos incluídos)
+#define LOG_MAX_STRING 128             // Argumentos %s são truncados a este tamanho
+#define LOG_FLUSH_INTERVAL_MS 10       // Período da thread de escrita
+#define LOG_ROTATE_ENV "PACMAN_LOG_MAX_BYTES"
+#define LOG_ROTATE_BYTES (16L * 1024 * 1024)
+#define LOG_ROTATE_KEEP 3              // Ficheiros antigos mantidos: <path>.1 (mais recente) a <path>.3
+
+/* File format (little-endian): LOG_MAGIC | version u8, then tagged records:
+     LOG_REC_FORMAT:  id u32 | len u16 | format bytes (first use in this file)
+     LOG_REC_MESSAGE: format id u32 | level u8 | thread u16 | CLOCK_REALTIME ns u64 |
+                      args len u16 | args (type byte + value, see log_arg_t)
+     LOG_REC_DROPPED: thread u16 | records dropped since the last report u32
+   Every rotated file starts its own format table. */
+typedef enum {
+    LOG_REC_FORMAT = 'F',
+    LOG_REC_MESSAGE = 'M',
+    LOG_REC_DROPPED = 'D',
+} log_tag_t;
+
+typedef enum {
+    LOG_ARG_NONE = 0,                  // %% (não consome argumento)
+    LOG_ARG_INT = 'i',                 // int64
+    LOG_ARG_UINT = 'u',                // uint64
+    LOG_ARG_DOUBLE = 'f',              // double
+    LOG_ARG_STRING = 's',              // len u16 | bytes
+    LOG_ARG_POINTER = 'p',             // uint64
+} log_arg_t;
+
+typedef enum {
+    LOG_MOD_NONE = 0, LOG_MOD_HH, LOG_MOD_H, LOG_MOD_L, LOG_MOD_LL,
+    LOG_MOD_Z, LOG_MOD_J, LOG_MOD_T, LOG_MOD_LONG_DOUBLE,
+} log_modifier_t;
+
+// Uma conversão printf
+typedef struct {
+    int length;                        // Caracteres desde o '%' até à conversão inclusive
+    char conversion;
+    log_arg_t arg;
+    log_modifier_t modifier;
+} log_spec_t;
+
+/*Parses the printf conversion starting at p (which points at '%').
+Returns 1 on success, 0 for conversions the logger cannot record (e.g. '*')*/
+int log_parse_spec(const char* p, log_spec_t* spec);
+
+/*Starts the writer thread on path (truncated). Rotation size comes from
+PACMAN_LOG_MAX_BYTES. Returns 0 on success*/
+int log_open(const char* path);
+
+/*Drains every ring, stops the writer thread and closes the file*/
+void log_close(void);
+
+void log_vwrite(int level, const char* format, va_list args);
+
+void log_write(int level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+#define LOG_AT(level, ...) \
+    do { if ((level) >= LOG_MIN_LEVEL) log_write((level), __VA_ARGS__); } while (0)
+
+#define log_debug(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define log_info(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define log_warn(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define log_error(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#endif
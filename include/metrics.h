@@ -0,0 +1,69 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#define METRICS_PATH_ENV "PACMAN_METRICS_PATH"
+#define METRICS_FILE_INTERVAL_MS 1000  // Período de reescrita quando o destino é um ficheiro regular
+#define METRICS_HIST_BUCKETS 28        // Histogramas log2 em ns: bucket i = [2^(i-1), 2^i) ns, até ~134 ms
+
+// Contadores monotónicos
+typedef enum {
+    METRIC_SESSIONS_STARTED = 0,
+    METRIC_TICKS,                      // Ticks de ghosts executados
+    METRIC_FRAMES_SENT,                // OP_CODE_BOARD escritos por inteiro
+    METRIC_FRAME_BYTES,
+    METRIC_FRAMES_DROPPED,             // write() falhado ou incompleto
+    METRIC_HANDSHAKE_FAILURES,         // CONNECT inválido ou FIFOs do cliente inacessíveis
+    METRIC_COUNTERS
+} metric_counter_t;
+
+// Gauges, somados a partir dos deltas de cada thread
+typedef enum {
+    METRIC_ACTIVE_SESSIONS = 0,
+    METRIC_QUEUED_CONNECTIONS,
+    METRIC_GAUGES
+} metric_gauge_t;
+
+// Histogramas de durações
+typedef enum {
+    METRIC_TICK_DURATION = 0,          // sched_run_tick de uma sessão
+    METRIC_MUTEX_WAIT,                 // Espera por board_mutex
+    METRIC_MUTEX_HOLD,                 // Tempo com board_mutex bloqueado
+    METRIC_LEVEL_SWITCH,               // Do frame de vitória ao nível seguinte em jogo
+    METRIC_HISTOGRAMS
+} metric_hist_t;
+
+/* Each thread updates only its own shard (plain relaxed stores, no shared
+atomics or locks on the hot path); the metrics thread sums every shard when
+it writes a dump. Shards of exiting threads are folded into a retired total.
+With PACMAN_METRICS_PATH unset every call below is a single branch. */
+
+/*Starts the metrics thread if PACMAN_METRICS_PATH is set. A FIFO (created if
+the path does not exist) gets one Prometheus text dump per reader, e.g.
+`cat $PACMAN_METRICS_PATH`; a regular file is rewritten every
+METRICS_FILE_INTERVAL_MS. Returns 0 (also when disabled), -1 on error*/
+int metrics_init(void);
+
+/*Stops the metrics thread*/
+void metrics_shutdown(void);
+
+void metrics_count(metric_counter_t counter, unsigned long n);
+
+void metrics_gauge_add(metric_gauge_t gauge, long delta);
+
+void metrics_observe(metric_hist_t hist, uint64_t ns);
+
+/*CLOCK_MONOTONIC in ns, or 0 when metrics are disabled*/
+uint64_t metrics_now(void);
+
+/*Records the wait for a lock requested at wait_start (a metrics_now() taken
+before locking). Returns the time the lock was taken, to be passed to
+metrics_lock_released()*/
+uint64_t metrics_lock_acquired(uint64_t wait_start);
+
+/*Records the time a lock was held since locked_at (call before unlocking)*/
+void metrics_lock_released(uint64_t locked_at);
+
+#endif
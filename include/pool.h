@@ -0,0 +1,55 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include "threads.h"
+
+#define POOL_SCALER_INTERVAL_MS 1000   // Período de avaliação da thread de escalonamento
+#define POOL_IDLE_TIMEOUT_MS 30000     // Tempo ocioso até uma gestora acima de min_games terminar
+#define POOL_MIN_CPU_IDLE 0.10         // Folga mínima de CPU para crescer acima de min_games
+
+typedef enum {
+    SLOT_FREE = 0,                     // Sem thread gestora
+    SLOT_IDLE,                         // Gestora à espera de pedidos
+    SLOT_BUSY,                         // Gestora a servir uma sessão
+} slot_state_t;
+
+// Pool elástico de threads gestoras de sessão
+typedef struct {
+    session_t** sessions;              // Sessão servida por cada slot (max_workers entradas)
+    slot_state_t* slot_state;          // Estado de cada slot
+    int min_workers;                   // Gestoras mantidas sempre vivas (min_games)
+    int max_workers;                   // Limite superior (max_games)
+    int n_workers;                     // Gestoras vivas
+    int n_busy;                        // Gestoras com sessão ativa
+    connection_buffer_t* buffer;       // Buffer produtor-consumidor partilhado
+    char* levels_directory;            // Diretório dos níveis
+    void* (*worker_func)(void*);       // Função das gestoras (recebe session_manager_args_t*)
+    void* warm;                        // warm_pool_t* passado às gestoras
+    pthread_mutex_t mutex;             // Protege os campos acima
+    pthread_cond_t workers_cond;       // Sinaliza saída de gestoras (shutdown)
+    pthread_t scaler_thread;           // Thread que ajusta a capacidade
+    volatile int running;              // 0 = pool a terminar
+    unsigned long long cpu_total;      // Última amostra de /proc/stat
+    unsigned long long cpu_idle;
+    double cpu_idle_ratio;             // Fração de CPU livre no último intervalo
+} session_pool_t;
+
+/*Creates the pool with min_workers threads and a ring of min_workers slots*/
+int pool_init(session_pool_t* pool, int min_workers, int max_workers,
+              connection_buffer_t* buffer, char* levels_directory,
+              void* (*worker_func)(void*), void* warm);
+
+/*Stops the scaler, wakes idle workers and waits for every worker to exit*/
+void pool_destroy(session_pool_t* pool);
+
+/*Queues a connection request, growing the ring and the workers if needed*/
+void pool_submit(session_pool_t* pool, connection_request_t* request);
+
+/*Publishes (or clears, with NULL) the session served by a slot*/
+void pool_set_session(session_pool_t* pool, int slot, session_t* session);
+
+/*Blocks the calling worker until a request arrives.
+Returns 0 with *request filled, or -1 if the worker must exit (idle or shutdown)*/
+int pool_next_request(session_pool_t* pool, int slot, connection_request_t* request);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef PREDICT_H
+#define PREDICT_H
+
+#include "api.h"
+
+/* Client-side prediction of the pacman's own moves. Commands are applied
+locally as soon as they are sent, against the walls of the last
+authoritative frame and with the same rules as move_pacman (boundaries,
+walls, PASSO waiting), so the player sees the move without a round trip.
+When a BOARD_SEQ frame arrives, the commands it acknowledges are dropped and
+the rest are replayed on top of it. The pacman's PASSO is not part of the
+protocol: it is learned from frames that acknowledge a single command, and
+moves whose outcome the model cannot know (waiting unknown, ghosts, portals)
+are left to the server. */
+
+#define PREDICT_ENV "PACMAN_PREDICT"   // "1" ativa a previsão no cliente
+#define PREDICT_MAX_PENDING 256        // Jogadas por confirmar guardadas
+
+// Estado do pacman que decide o resultado de uma jogada
+typedef struct {
+    int pos;                           // Índice da célula (-1 = sem pacman)
+    int waiting;                       // Jogadas que ainda espera (-1 = desconhecido)
+    int since_move;                    // Esperas desde o último reinício do waiting (-1 = desconhecido)
+    int points;
+} predict_model_t;
+
+typedef struct {
+    char command;
+    unsigned int seq;
+    int predicted_pos;                 // Índice previsto depois da jogada (-1 = não prevista)
+} predict_input_t;
+
+typedef struct {
+    int width, height;
+    char* base;                        // Último frame autoritativo
+    char* cells;                       // base + jogadas pendentes (o que se desenha)
+    size_t capacity;
+    predict_model_t base_model;        // Pacman no frame base
+    predict_model_t tip;               // Pacman depois de todas as jogadas pendentes
+    int stalled;                       // Uma pendente não era previsível: as seguintes esperam pelo servidor
+    int passo;                         // PASSO aprendido (-1 = desconhecido)
+    predict_input_t pending[PREDICT_MAX_PENDING];
+    int n_pending;
+    Board board;                       // Frame previsto (data = cells)
+    unsigned long predicted;           // Jogadas previstas já confirmadas
+    unsigned long corrected;           // ... em que o servidor discordou
+} predictor_t;
+
+void predictor_init(predictor_t* predictor);
+
+void predictor_free(predictor_t* predictor);
+
+/*Applies a command just sent with sequence number seq on top of the
+prediction. Returns the board to draw, or NULL if nothing visible changed*/
+const Board* predictor_input(predictor_t* predictor, char command, unsigned int seq);
+
+/*Makes frame the new authoritative base, drops the commands it
+acknowledges and replays the others. Returns the board to draw (valid until
+the next predictor call)*/
+const Board* predictor_frame(predictor_t* predictor, const Board* frame);
+
+#endif
@@ -8,6 +8,21 @@ enum {
   OP_CODE_DISCONNECT = 2,
   OP_CODE_PLAY = 3,
   OP_CODE_BOARD = 4,
+  OP_CODE_PLAY_SEQ = 5,   // PLAY com número de sequência: op | comando | seq u32
+  OP_CODE_BOARD_SEQ = 6,  // BOARD seguido de última seq aplicada u32 e tick u32
+  OP_CODE_NEW_GAME = 7,   // Depois de vitória/game over: op | modo, mantém a ligação
 };
 
+// Modo de OP_CODE_NEW_GAME
+enum {
+  NEW_GAME_RESTART = 0,     // Primeiro nível, pontos a zero
+  NEW_GAME_NEXT_LEVEL = 1,  // Nível seguinte (volta ao primeiro depois do último), pontos mantidos
+};
+
+// Tamanho das mensagens do cliente para o servidor
+#define MSG_DISCONNECT_SIZE 1
+#define MSG_PLAY_SIZE 2
+#define MSG_PLAY_SEQ_SIZE 6
+#define MSG_NEW_GAME_SIZE 2
+
 #endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef RANKING_H
+#define RANKING_H
+
+#define RANKING_PATH "ranking.log"
+#define RANKING_TOP 5                  // Clientes escritos em ranking.log
+
+/* Live score ranking of the active sessions. Each session owns an entry and
+publishes its points when they change; the table keeps the RANKING_TOP best
+entries sorted as updates arrive, so producing the ranking is a copy of
+RANKING_TOP entries under one short lock, however many sessions are live.
+SIGUSR1 is read from a signalfd by a dedicated thread, which writes
+ranking.log immediately (temporary file + rename, so readers never see a
+partial file). */
+
+/*Opens the SIGUSR1 signalfd and starts the ranking thread. SIGUSR1 must
+already be blocked in every thread (main blocks it before creating any).
+Returns 0 on success, -1 on error*/
+int ranking_init(void);
+
+/*Stops the ranking thread*/
+void ranking_shutdown(void);
+
+/*Adds an entry for client_id with the given points. Returns its handle*/
+int ranking_join(int client_id, int points);
+
+/*Publishes the current points of an entry*/
+void ranking_update(int handle, int points);
+
+/*Removes an entry (session ended)*/
+void ranking_leave(int handle);
+
+/*Writes the current top RANKING_TOP to ranking.log. Returns 0 on success*/
+int ranking_write(void);
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "board.h"
+#include "sched.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Formato de gravação (.pmr), little-endian:
+   cabeçalho: "PMRC" | versão u8 | seed u64 | tempo u32 | len u8 | nome do nível
+              | (versão >= 3) pontos iniciais u32 | índice do nível u16
+   registos:  tag u8 seguido do corpo
+     REC_INPUT:    varint delta do tick | comando u8
+     REC_KEYFRAME: varint delta do tick | varint tamanho | estado (ver replay.c)
+     REC_END:      varint delta do tick | resultado u8 | varint pontos
+     REC_INDEX:    varint n | n x (varint delta do tick, varint delta do offset)
+   rodapé (12 bytes): offset u64 do REC_INDEX | "PMRI"
+   O tick de um registo é o número de ticks de ghosts já executados quando
+   aconteceu, por isso uma jogada com tick t corre antes do tick t dos ghosts.
+   Um keyframe com tick k guarda o estado logo após o tick k - 1. */
+
+#define REPLAY_MAGIC "PMRC"
+#define REPLAY_INDEX_MAGIC "PMRI"
+#define REPLAY_VERSION 3
+#define REPLAY_RECORD_DIR_ENV "PACMAN_RECORD_DIR"
+#define REPLAY_KEYFRAME_ENV "PACMAN_KEYFRAME_INTERVAL"
+#define REPLAY_KEYFRAME_INTERVAL 256   // Ticks entre keyframes (custo máximo de um seek)
+
+typedef enum {
+    REC_INPUT = 1,                     // OP_CODE_PLAY descodificado
+    REC_END = 2,                       // Fim do jogo
+    REC_KEYFRAME = 3,                  // Estado completo do jogo
+    REC_INDEX = 4,                     // Índice de keyframes (só no rodapé)
+} replay_tag_t;
+
+typedef enum {
+    REPLAY_DISCONNECTED = 0,
+    REPLAY_VICTORY = 1,
+    REPLAY_DEAD = 2,
+} replay_outcome_t;
+
+// Entrada do índice de seek
+typedef struct {
+    unsigned long tick;
+    size_t offset;                     // Offset da tag REC_KEYFRAME
+} replay_keyframe_t;
+
+// Gravador de uma sessão (escrito pelas threads do jogo com board_mutex bloqueado)
+typedef struct {
+    FILE* file;
+    unsigned long last_tick;           // Base dos deltas
+    unsigned long n_inputs;
+    unsigned long keyframe_interval;
+    unsigned long next_keyframe;       // Tick a partir do qual se grava o próximo keyframe
+    replay_keyframe_t* keyframes;      // Índice escrito no fecho
+    int n_keyframes;
+    int keyframes_capacity;
+} recorder_t;
+
+// Gravação carregada em memória
+typedef struct {
+    unsigned char* data;
+    size_t size;
+    size_t end;                        // Fim dos registos (início do índice, se existir)
+    size_t pos;                        // Cursor de leitura
+    size_t records;                    // Offset do primeiro registo
+    unsigned long last_tick;           // Base dos deltas durante a leitura
+    uint64_t seed;
+    int tempo;
+    char level_name[MAX_FILENAME];
+    int start_points;                  // Pontos trazidos dos níveis anteriores do jogo
+    int level_index;                   // Posição do nível na ordem de jogo (0 = primeiro)
+    replay_keyframe_t* keyframes;      // Do rodapé, ou reconstruído por varrimento
+    int n_keyframes;
+} replay_t;
+
+typedef struct {
+    int type;                          // replay_tag_t
+    unsigned long tick;
+    char command;                      // REC_INPUT
+    int outcome;                       // REC_END
+    int points;                        // REC_END
+    size_t body;                       // REC_KEYFRAME: offset do estado
+    size_t body_size;
+} replay_record_t;
+
+// Reprodução passo a passo de uma gravação
+typedef struct {
+    replay_t* replay;
+    level_data_t* level_data;          // Nível de onde o board é reconstruído
+    char* levels_directory;
+    board_t board;
+    entity_sched_t sched;
+    replay_record_t record;            // Próximo registo por aplicar
+    int have;                          // 1 = record válido, 0 = fim, -1 = corrompido
+    unsigned long tick;                // Ticks de ghosts já simulados
+    int outcome;                       // replay_outcome_t
+    int finished;                      // 1 = jogo acabou (portal, morte ou REC_END)
+    unsigned long inputs;              // Jogadas aplicadas
+    unsigned long ghost_moves;         // Ações de ghosts executadas
+} replay_player_t;
+
+typedef struct {
+    unsigned long ticks;               // Ticks de ghosts simulados
+    unsigned long inputs;
+    unsigned long ghost_moves;
+    int outcome;                       // replay_outcome_t obtido
+    int points;
+    int has_end;                       // 0 = gravação truncada (sem REC_END)
+    unsigned long expected_ticks;      // Valores gravados pelo servidor
+    int expected_outcome;
+    int expected_points;
+} replay_result_t;
+
+/*Creates <dir>/client<id>-<timestamp>.pmr and writes the header for board,
+including the points it starts with and its position in the game's level
+order. The keyframe interval comes from PACMAN_KEYFRAME_INTERVAL (0
+disables them). Returns NULL if the file cannot be created*/
+recorder_t* recorder_open(const char* dir, int client_id, board_t* board, int level_index);
+
+/*Appends one decoded PLAY command applied after tick ghost ticks*/
+void recorder_input(recorder_t* recorder, unsigned long tick, char command);
+
+/*Called after each ghost tick (tick = ticks run so far); writes a keyframe
+when the interval has elapsed*/
+void recorder_tick(recorder_t* recorder, unsigned long tick, board_t* board, entity_sched_t* sched);
+
+/*Appends the final record*/
+void recorder_end(recorder_t* recorder, unsigned long tick, int outcome, int points);
+
+/*Writes the seek index and footer, then frees the recorder*/
+void recorder_close(recorder_t* recorder);
+
+/*Reads a whole recording into memory and parses its header and seek index
+(rebuilt by scanning if the footer is missing). Returns 0 on success*/
+int replay_load(replay_t* replay, const char* path);
+
+void replay_free(replay_t* replay);
+
+/*Moves the cursor back to the first record*/
+void replay_rewind(replay_t* replay);
+
+/*Decodes the next record. Returns 1 on success, 0 at end of data, -1 if corrupt*/
+int replay_next(replay_t* replay, replay_record_t* record);
+
+/*Builds a fresh board from level_data positioned at tick 0, with the
+recording's starting points. Returns 0 on success*/
+int replay_player_init(replay_player_t* player, replay_t* replay, level_data_t* level_data,
+                       char* levels_directory);
+
+void replay_player_destroy(replay_player_t* player);
+
+/*Runs every input and ghost tick that happens before tick until (or to the
+end of the game). Returns 0, or -1 if the stream is corrupt*/
+int replay_advance(replay_player_t* player, unsigned long until);
+
+/*Jumps to the state right before tick: restores the last keyframe at or
+before it and replays only the records after that keyframe.
+*keyframe_tick (optional) gets the keyframe used (0 = start of game)*/
+int replay_seek(replay_player_t* player, unsigned long tick, unsigned long* keyframe_tick);
+
+/*Replays the whole recording headlessly (no clock, no threads) and compares
+the outcome with the recorded one. Returns 0 on success, -1 if the level or
+the stream cannot be used*/
+int replay_run(replay_t* replay, level_data_t* level_data, char* levels_directory,
+               replay_result_t* result);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Gerador PCG32 (O'Neill): estado de 64 bits, saída de 32 bits, sem estado global
+typedef struct {
+    uint64_t state;
+    uint64_t inc;                      // Sequência (sempre ímpar)
+} rng_t;
+
+static inline uint32_t rng_next(rng_t* rng) {
+    uint64_t old = rng->state;
+    rng->state = old * 6364136223846793005ULL + rng->inc;
+    uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+    uint32_t rot = (uint32_t)(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31u));
+}
+
+/*Seeds rng; the same seed always yields the same sequence*/
+static inline void rng_seed(rng_t* rng, uint64_t seed) {
+    rng->state = 0;
+    rng->inc = (seed << 1u) | 1u;
+    rng_next(rng);
+    rng->state += seed;
+    rng_next(rng);
+}
+
+/*Uniform value in [0, bound) (multiply-shift, no modulo)*/
+static inline uint32_t rng_bounded(rng_t* rng, uint32_t bound) {
+    return (uint32_t)(((uint64_t)rng_next(rng) * bound) >> 32);
+}
+
+#endif
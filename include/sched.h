@@ -0,0 +1,44 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include "board.h"
+
+#define SCHED_IDLE ((unsigned long)-1) // Nenhuma entidade agendada
+
+// Próxima ação de um ghost
+typedef struct {
+    unsigned long due;                 // Tick em que o ghost volta a agir
+    int ghost_index;                   // Índice em board->ghosts
+} sched_entry_t;
+
+// Min-heap por sessão ordenado por (due, ghost_index)
+typedef struct {
+    sched_entry_t* heap;
+    int size;
+} entity_sched_t;
+
+/*Schedules every ghost with moves to act on tick first_tick*/
+int sched_init(entity_sched_t* sched, board_t* board, unsigned long first_tick);
+
+void sched_destroy(entity_sched_t* sched);
+
+/*Rebuilds the heap from saved due ticks (due[i] == SCHED_IDLE = not scheduled)*/
+void sched_restore(entity_sched_t* sched, board_t* board, const unsigned long* due);
+
+/*Tick at which ghost_index acts next, or SCHED_IDLE*/
+unsigned long sched_due(entity_sched_t* sched, int ghost_index);
+
+/*Tick of the earliest scheduled action, or SCHED_IDLE*/
+unsigned long sched_next_due(entity_sched_t* sched);
+
+/*Runs every ghost due at or before tick, in (due, index) order, and
+reschedules each one passo ticks later. The PASSO countdown is skipped
+instead of being decremented tick by tick. Returns DEAD_PACMAN if a ghost
+killed the pacman, VALID_MOVE otherwise; *n_acted gets the number of ghosts run*/
+int sched_run_tick(entity_sched_t* sched, board_t* board, unsigned long tick, int* n_acted);
+
+/*Applies one user command to pacman 0 between ghost ticks (live sessions and
+replays share this path). Returns the move_pacman result*/
+int sched_apply_input(board_t* board, char command);
+
+#endif
@@ -2,7 +2,6 @@
 #define SERVER_DISPLAY_H
 
 #include "board.h"
-#include <ncurses.h>
 
 
 #define DRAW_GAME_OVER 0
@@ -11,10 +10,10 @@
 
 
 /*
-Potential Structures for ncurses
+Drawn with the raw ANSI backend (ansi.h), no ncurses
 */
 
-/*Initialize everything ncurses requires*/
+/*Prepare the ANSI screen on stdout*/
 int terminal_init();
 
 /*Draw the board on the screen*/
@@ -32,10 +31,10 @@ Pre loaded colours:
 */
 void draw(char c, int colour_i, int pos_x, int pos_y);
 
-/*Call ncurses refresh() to update the screen*/
+/*Write every change since the last refresh to the terminal*/
 void refresh_screen();
 
-/*Ncurses will be reading the player's inputs*/
+/*Read the player's inputs from stdin*/
 char get_input();
 
 void terminal_cleanup();
@@ -0,0 +1,64 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "board.h"
+#include "threads.h"
+
+/* A session keeps its FIFOs, board and game threads for as many games as
+the client wants: after the final frame of a game the client may send
+OP_CODE_NEW_GAME instead of disconnecting, and the parked threads play the
+next game on the same board memory.
+
+Within a game the levels are played in order. While one is being played the
+manager loads the next into a spare board (next_template); on a portal the
+update thread sends the victory frame and copies that board over the live
+one, carrying the points, so the level change costs a memcpy and the
+threads never stop. The game ends (game_over in the final frame) on death,
+disconnection or after the last level. */
+
+#define NEXT_GAME_CLOSE -1             // Cliente desligou (ou não pediu outro jogo a tempo)
+#define NEXT_GAME_PENDING -2           // Jogo a decorrer ou à espera do pedido do cliente
+#define SESSION_IDLE_TIMEOUT_MS 30000  // Espera máxima por OP_CODE_NEW_GAME depois do fim do jogo
+
+// Níveis do servidor pela ordem de jogo (parseados no arranque, só leitura depois)
+typedef struct {
+    char* directory;
+    level_data_t* levels;
+    int n_levels;
+} level_list_t;
+
+/*Builds a session ready to be handed to a client: first level loaded, frame
+buffer allocated and game threads created but parked until session_start().
+levels must outlive the session. Returns NULL if the level could not be loaded*/
+session_t* session_prepare(level_list_t* levels);
+
+/*Opens the client FIFOs named in request and sends the CONNECT response.
+Returns 0 on success; on failure the session is left unbound and reusable*/
+int session_bind(session_t* session, connection_request_t* request);
+
+/*Seed for a new game: PACMAN_SEED from the environment if set (tests and
+replays), otherwise fresh entropy*/
+uint64_t session_choose_seed(void);
+
+/*Seeds the board's generator and wakes the parked game threads for a new game*/
+void session_start(session_t* session, uint64_t seed);
+
+/*Blocks until the game ends and its final frame has been sent, then records
+the result. Meanwhile prefetches each next level. The game threads stay
+parked for the next game*/
+void session_wait(session_t* session);
+
+/*Blocks until the client asks for another game after the one that ended.
+Returns NEW_GAME_RESTART, NEW_GAME_NEXT_LEVEL or NEXT_GAME_CLOSE*/
+int session_next_game(session_t* session);
+
+/*Prepares the game asked for with OP_CODE_NEW_GAME: the first level with no
+points (NEW_GAME_RESTART) or the level after the current one keeping the
+points (NEW_GAME_NEXT_LEVEL). Reuses the board and frame buffer memory.
+Call only between session_wait() and session_start(). Returns 0 on success*/
+int session_reset(session_t* session, int mode);
+
+/*Stops any remaining threads, closes the FIFOs and frees the session*/
+void session_release(session_t* session);
+
+#endif
@@ -4,6 +4,8 @@
 #include <pthread.h>
 #include <sys/types.h>
 #include <semaphore.h>
+#include "clock.h"
+#include "lockprof.h"
 
 #define MAX_PIPE_PATH_LENGTH 40
 
@@ -11,21 +13,35 @@ typedef struct {
     pthread_mutex_t board_mutex;           // Protege acesso ao board_t
     pthread_cond_t display_ready_cond;     // Sinaliza display thread
     pthread_cond_t game_tick_cond;         // Sinaliza fim do desenho
+    pthread_cond_t start_cond;             // Acorda as threads estacionadas (sessão pré-construída ou entre jogos)
+    pthread_cond_t game_done_cond;         // Acorda a gestora: threads acabaram o jogo, o cliente decidiu ou mudou o nível
+    tick_wake_t ghost_wake;                // Acorda o escalonador de ghosts antes do prazo (novo nível, fim do jogo)
+    int pacman_wake[2];                    // Pipe não bloqueante: acorda a thread do pacman presa no pipe de pedidos
     
     volatile int game_running;             // 1 = jogo ativo, 0 = terminar
     volatile int display_ready;            // 1 = precisa redesenhar
-    volatile int level_complete;           // 1 = portal alcançado
+    volatile int level_complete;           // 1 = portal alcançado (com game_running, à espera do nível seguinte)
     volatile int pacman_dead;              // 1 = pacman morreu
     volatile int quick_save_requested;      // NOVO: flag para G key
+    unsigned int game_id;                  // Jogo atual (session_start incrementa; 0 = nenhum ainda)
+    volatile int closing;                  // 1 = sessão a ser libertada: threads estacionadas saem
+    int playing;                           // Threads de ghosts e de updates ainda no jogo atual
+    int next_game;                         // Pedido do cliente no fim do jogo (NEW_GAME_*, ou NEXT_GAME_*)
+    unsigned int level_id;                 // Incrementado a cada passagem de nível dentro do jogo
+    unsigned long tick;                    // Ticks de ghosts já executados (carimbo das jogadas gravadas)
+    unsigned int last_seq;                 // Sequência do último OP_CODE_PLAY_SEQ aplicado
+    int seq_frames;                        // 1 = cliente usa sequências, enviar OP_CODE_BOARD_SEQ
+#ifdef LOCK_PROFILING
+    lock_profile_t board_profile;          // Contenção de board_mutex por local de chamada
+#endif
 } game_sync_t;
 
-// Estruturas para argumentos das threads
-typedef struct {
-    void* board;                           // board_t*
-    int entity_index;                      // Índice do ghost (0 = primeiro)
-    game_sync_t* sync;                     // Ponteiro para sincronização
-} ghost_thread_args_t;
+// Acesso a board_mutex; com LOCK_PROFILING cada local de chamada é perfilado
+#define board_lock(sync) prof_lock(&(sync)->board_mutex, &(sync)->board_profile)
+#define board_unlock(sync) prof_unlock(&(sync)->board_mutex, &(sync)->board_profile)
+#define board_wait(cond, sync) prof_cond_wait((cond), &(sync)->board_mutex, &(sync)->board_profile)
 
+// Estruturas para argumentos das threads
 typedef struct {
     void* board;                           // board_t*
     game_sync_t* sync;                     // Ponteiro para sincronização
@@ -45,10 +61,13 @@ typedef struct {
     int head;                          // Índice de inserção (produtor)
     int tail;                          // Índice de extração (consumidor)
     int count;                         // Número de pedidos no buffer
-    int max_size;                      // Tamanho máximo (max_games)
+    int max_size;                      // Capacidade atual do anel (elástica, entre min_games e max_games)
     pthread_mutex_t mutex;             // Protege acesso ao buffer
     sem_t empty;                       // Semáforo: slots vazios
     sem_t full;                        // Semáforo: slots ocupados
+#ifdef LOCK_PROFILING
+    lock_profile_t profile;            // Contenção de mutex por local de chamada
+#endif
 } connection_buffer_t;
 
 // Estrutura de sessão (uma por cliente)
@@ -61,29 +80,62 @@ typedef struct {
     char notif_pipe_path[MAX_PIPE_PATH_LENGTH + 1];
     void* board;                       // board_t* (ponteiro para tabuleiro da sessão)
     pthread_t pacman_thread;           // Thread do pacman desta sessão
-    pthread_t* ghost_threads;          // Array de threads dos ghosts
-    int n_ghost_threads;               // Número de threads de ghosts
+    pthread_t ghost_thread;            // Escalonador de todos os ghosts desta sessão
     pthread_t board_update_thread;     // Thread que envia updates periódicos
+    int threads_running;               // 1 = threads do jogo ainda por juntar
+    char* frame_buf;                   // Buffer pré-alocado para serializar OP_CODE_BOARD
+    int frame_buf_size;                // Tamanho de frame_buf
+    struct timespec epoch;             // Início do tick 0 (fixado em session_start)
+    tick_stats_t tick_stats;           // Jitter/ultrapassagens dos ticks dos ghosts
+    void* recorder;                    // recorder_t* (NULL = sessão não gravada)
+    int level_finished;                // Resultado do nível atual já registado (leaderboard e gravação)
+    int ranking_handle;                // Entrada no ranking (-1 = fora do ranking)
+    void* levels;                      // level_list_t* (níveis por ordem, partilhados pelas sessões)
+    void* level_template;              // board_t* no estado inicial do nível atual, copiado para board
+    void* next_template;               // board_t* do nível seguinte, pré-carregado durante o jogo (NULL = ainda não)
+    void* spare_template;              // board_t* de um nível já jogado, reaproveitado no próximo pré-carregamento
+    int level_index;                   // Posição do nível atual em levels
+    int level_limit;                   // Níveis jogáveis (encolhe se o pré-carregamento falhar)
     game_sync_t sync;                  // Sincronização específica desta sessão
 } session_t;
 
 // Argumentos para thread gestora de sessão
 typedef struct {
     int session_index;                 // Índice no array de sessões
-    session_t* sessions;               // Ponteiro para array de sessões
+    session_t** sessions;              // Ponteiro para array de sessões (NULL = slot sem jogo)
     connection_buffer_t* buffer;       // Ponteiro para buffer produtor-consumidor
     char* levels_directory;            // Diretório dos níveis
+    void* pool;                        // session_pool_t* (pool elástico de gestoras)
+    void* warm;                        // warm_pool_t* (sessões pré-construídas)
 } session_manager_args_t;
 
 // Argumentos para thread anfitriã (host)
 typedef struct {
     int register_pipe_fd;              // FD do pipe de registo
     connection_buffer_t* buffer;       // Ponteiro para buffer produtor-consumidor
+    void* pool;                        // session_pool_t* (recebe os pedidos)
 } host_thread_args_t;
 
 // Funções de inicialização
 int init_game_sync(game_sync_t* sync);
 void destroy_game_sync(game_sync_t* sync);
 
+// Buffer produtor-consumidor
+int init_connection_buffer(connection_buffer_t* buffer, int capacity);
+void destroy_connection_buffer(connection_buffer_t* buffer);
+
+/* Lê count e max_size sob buffer->mutex. Qualquer ponteiro pode ser NULL. */
+void connection_buffer_stats(connection_buffer_t* buffer, int* count, int* capacity);
+
+/* Duplica a capacidade do anel, até limit, preservando os pedidos pendentes.
+Devolve a nova capacidade e escreve a anterior em old_capacity (se não NULL). */
+int grow_connection_buffer(connection_buffer_t* buffer, int limit, int* old_capacity);
+
+/* Reduz o anel para metade (nunca abaixo de floor) quando tem no máximo um
+quarto ocupado. Apenas retira slots vazios que consiga reservar no semáforo
+empty, por isso a capacidade final pode ficar acima do pedido. Devolve a nova
+capacidade e escreve a anterior em old_capacity (se não NULL). */
+int shrink_connection_buffer(connection_buffer_t* buffer, int floor, int* old_capacity);
+
 #endif
 
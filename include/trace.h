@@ -0,0 +1,45 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <signal.h>
+
+#define TRACE_PATH_ENV "PACMAN_TRACE"
+#define TRACE_RING_EVENTS 8192         // Eventos guardados por thread (os mais antigos são sobrescritos)
+#define TRACE_MAX_RETIRED 32           // Anéis de threads terminadas mantidos para o próximo flush
+
+/* Event trace in Chrome trace format (chrome://tracing, ui.perfetto.dev).
+Each thread writes complete events (begin time + duration) into its own
+ring; nothing is shared on the hot path. With PACMAN_TRACE unset every call
+is a single branch. Event names must be string literals. */
+
+/*Adds to set the signals the trace thread waits for when PACMAN_TRACE is
+set: SIGUSR2 (flush), SIGINT and SIGTERM (flush, then exit). main blocks
+them before creating any thread, so only the trace thread receives them*/
+void trace_add_signals(sigset_t* set);
+
+/*Enables tracing if PACMAN_TRACE names an output file and starts the
+thread that handles the signals of trace_add_signals().
+Returns 0 (also when disabled), -1 on error*/
+int trace_init(void);
+
+/*Writes the trace file and stops the signal thread*/
+void trace_shutdown(void);
+
+/*Writes every ring to the trace file (replacing it). Returns 0 on success*/
+int trace_flush(void);
+
+/*Names the calling thread in the trace and sets the session its events are
+tagged with (-1 = none)*/
+void trace_thread(const char* name, int session);
+
+/*Changes the session tag of the calling thread's next events*/
+void trace_set_session(int session);
+
+/*Start time of an event (0 when tracing is disabled)*/
+uint64_t trace_begin(void);
+
+/*Records the event name that started at start*/
+void trace_end(const char* name, uint64_t start);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef WARM_H
+#define WARM_H
+
+#include "board.h"
+#include "threads.h"
+#include "session.h"
+
+#define WARM_POOL_SIZE 2               // Sessões pré-construídas mantidas prontas
+
+// Pool de sessões pré-construídas (board carregado, buffers e threads estacionadas)
+typedef struct {
+    level_list_t levels;               // Níveis por ordem de jogo, parseados uma vez no arranque
+    session_t* ready[WARM_POOL_SIZE];  // Sessões prontas a entregar
+    int n_ready;
+    pthread_mutex_t mutex;             // Protege ready/n_ready
+    pthread_cond_t refill_cond;        // Acorda a thread de reposição
+    pthread_t refill_thread;           // Reconstrói sessões em segundo plano
+    volatile int running;              // 0 = pool a terminar
+} warm_pool_t;
+
+/*Lists the levels in play order (numeric names by value), parses them once
+and starts the background refill thread. Levels that fail to parse are
+skipped. Returns -1 if no level could be loaded*/
+int warm_pool_init(warm_pool_t* warm, char* levels_directory);
+
+/*Stops the refill thread and releases every unused session*/
+void warm_pool_destroy(warm_pool_t* warm);
+
+/*Takes a ready session, building one synchronously if the pool is empty*/
+session_t* warm_pool_acquire(warm_pool_t* warm);
+
+/*Gives back a session that was never started (e.g. the client vanished)*/
+void warm_pool_return(warm_pool_t* warm, session_t* session);
+
+#endif
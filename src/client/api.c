@@ -4,245 +4,430 @@
 
 #include <errno.h> 
 #include <fcntl.h>
+#include <limits.h>
 #include <unistd.h>
 #include <string.h>
 #include <stdio.h>
 #include <sys/stat.h>
 #include <stdlib.h>
+#include <poll.h>
 
 
-struct Session {
-  int id;
+#define RECEIVER_MIN_CAPACITY (64 * 1024)  // Tamanho mínimo de cada buffer de receção
+#define PLAY_BATCH_CHUNK (PIPE_BUF / MSG_PLAY_SEQ_SIZE)  // Jogadas por write() atómico
+
+#define CONNECT_MSG_SIZE 81  // OP_CODE=1 (1 byte) + req_pipe_path[40] + notif_pipe_path[40]
+
+enum {
+  SESSION_CONNECTING,     // CONNECT enviado, à espera da resposta
+  SESSION_PLAYING,        // A receber frames
+  SESSION_CLOSED,         // Servidor fechou, rejeitou ou enviou dados inválidos
+};
+
+struct pacman_session {
   int req_pipe;
   int notif_pipe;
   char req_pipe_path[MAX_PIPE_PATH_LENGTH + 1];
   char notif_pipe_path[MAX_PIPE_PATH_LENGTH + 1];
+  unsigned int next_seq;  // Próximo número de sequência de pacman_play_seq()
+  int state;
+  char response[2];       // Resposta ao CONNECT
+  int response_len;
+  char* buf;              // Bytes recebidos e ainda não devolvidos: [start, end)
+  size_t capacity;
+  size_t start;
+  size_t end;
+  size_t consumed;        // Tamanho do frame devolvido pela última pacman_try_receive()
+  int eof;
+  Board board;
 };
 
-static struct Session session __attribute__((unused)) = {.id = -1};
+// Sessão da API global (pacman_connect e companhia)
+static pacman_session_t* session = NULL;
 
-int pacman_connect(char const *req_pipe_path, char const *notif_pipe_path, char const *server_pipe_path) {
+static ssize_t frame_length(const char* p, size_t available);
+static void decode_frame(const char* frame, Board* board);
+
+// ========== SESSÕES ==========
+
+static void session_unlink(pacman_session_t* s) {
+  unlink(s->req_pipe_path);
+  unlink(s->notif_pipe_path);
+}
+
+static int write_all(int fd, const char* data, size_t size) {
+  size_t written = 0;
+  while (written < size) {
+    ssize_t n = write(fd, data + written, size - written);
+    if (n == -1) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    written += n;
+  }
+  return 0;
+}
+
+pacman_session_t* pacman_session_open(char const *req_pipe_path, char const *notif_pipe_path,
+                                      char const *server_pipe_path) {
+  pacman_session_t* s = calloc(1, sizeof(pacman_session_t));
+  if (s == NULL) {
+    perror("[ERR]: calloc(pacman_session_t) failed");
+    return NULL;
+  }
+  s->req_pipe = -1;
+  s->notif_pipe = -1;
+  s->next_seq = 1;
+  s->state = SESSION_CONNECTING;
+
+  // Guardar paths na sessão
+  strncpy(s->req_pipe_path, req_pipe_path, MAX_PIPE_PATH_LENGTH);
+  strncpy(s->notif_pipe_path, notif_pipe_path, MAX_PIPE_PATH_LENGTH);
 
   if (unlink(req_pipe_path) != 0 && errno != ENOENT) {
     perror("[ERR]: unlink(req_pipe_path) failed");
-    return 1;
+    free(s);
+    return NULL;
   }
 
   if (mkfifo(req_pipe_path, 0640) != 0) {
     perror("[ERR]: mkfifo(req_pipe_path) failed");
-    return 1;
-  } 
+    free(s);
+    return NULL;
+  }
   // Remover FIFO de notificações se já existir
   if (unlink(notif_pipe_path) != 0 && errno != ENOENT) {
     perror("[ERR]: unlink(notif_pipe_path) failed");
-    return 1;
+    unlink(req_pipe_path);
+    free(s);
+    return NULL;
   }
 
   // Criar FIFO de notificações
   if (mkfifo(notif_pipe_path, 0640) != 0) {
     perror("[ERR]: mkfifo(notif_pipe_path) failed");
-    return 1;
+    unlink(req_pipe_path);
+    free(s);
+    return NULL;
   }
 
-   // Guardar paths na struct Session
-  strncpy(session.req_pipe_path, req_pipe_path, MAX_PIPE_PATH_LENGTH);
-  session.req_pipe_path[MAX_PIPE_PATH_LENGTH] = '\0';
-  
-  strncpy(session.notif_pipe_path, notif_pipe_path, MAX_PIPE_PATH_LENGTH);
-  session.notif_pipe_path[MAX_PIPE_PATH_LENGTH] = '\0';
+  // Nenhuma open espera pelo servidor: notificações em O_NONBLOCK, pedidos em O_RDWR
+  s->notif_pipe = open(notif_pipe_path, O_RDONLY | O_NONBLOCK);
+  s->req_pipe = open(req_pipe_path, O_RDWR);
+  if (s->notif_pipe == -1 || s->req_pipe == -1) {
+    perror("[ERR]: open(session pipes) failed");
+    pacman_session_close(s);
+    return NULL;
+  }
 
   int server_fd = open(server_pipe_path, O_WRONLY);
   if (server_fd == -1) {
     perror("[ERR]: open(server_pipe_path) failed");
-    unlink(req_pipe_path);
-    unlink(notif_pipe_path);
-    return 1;
+    pacman_session_close(s);
+    return NULL;
   }
-  // Preparar mensagem CONNECT
-  // OP_CODE=1 (1 byte) + req_pipe_path[40] + notif_pipe_path[40] = 81 bytes
-  char msg[81];
-  msg[0] = OP_CODE_CONNECT;
 
-  // Preencher req_pipe_path (40 bytes, padding com \0)
-  memset(msg + 1, 0, 40);
+  // Preparar mensagem CONNECT (paths com padding de \0)
+  char msg[CONNECT_MSG_SIZE];
+  memset(msg, 0, sizeof(msg));
+  msg[0] = OP_CODE_CONNECT;
   strncpy(msg + 1, req_pipe_path, MAX_PIPE_PATH_LENGTH);
-
-  // Preencher notif_pipe_path (40 bytes, padding com \0)
-  memset(msg + 41, 0, 40);
   strncpy(msg + 41, notif_pipe_path, MAX_PIPE_PATH_LENGTH);
 
-  ssize_t bytes_written = 0;
-  ssize_t total_bytes = 81;
+  if (write_all(server_fd, msg, sizeof(msg)) != 0) {
+    perror("[ERR]: write(server_pipe_path) failed");
+    close(server_fd);
+    pacman_session_close(s);
+    return NULL;
+  }
+  close(server_fd);
 
-  while (bytes_written < total_bytes) {
-    ssize_t n = write(server_fd, msg + bytes_written, total_bytes - bytes_written);
-    if (n == -1) {
-      perror("[ERR]: write(server_pipe_path) failed");
-      close(server_fd);
-      unlink(req_pipe_path);
-      unlink(notif_pipe_path);
-      return 1;
+  return s;
+}
+
+int pacman_session_fd(const pacman_session_t* s) {
+  return s ? s->notif_pipe : -1;
+}
+
+/* Lê a resposta ao CONNECT sem consumir bytes do primeiro frame. */
+static pacman_event_t session_read_response(pacman_session_t* s) {
+  while (s->response_len < 2) {
+    ssize_t n = read(s->notif_pipe, s->response + s->response_len, 2 - s->response_len);
+    if (n > 0) {
+      s->response_len += n;
+      continue;
+    }
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && errno == EAGAIN) {
+      return PACMAN_EVENT_NONE;
+    }
+    if (n == 0) {
+      // Sem escritor: só é fim se o servidor já abriu o pipe e o fechou (POLLHUP)
+      struct pollfd pfd = {.fd = s->notif_pipe, .events = POLLIN};
+      if (poll(&pfd, 1, 0) <= 0 || !(pfd.revents & POLLHUP)) {
+        return PACMAN_EVENT_NONE;
+      }
     }
-    bytes_written += n;
+    s->state = SESSION_CLOSED;
+    return PACMAN_EVENT_CLOSED;
   }
 
-  close(server_fd);
-
-  session.req_pipe = open(req_pipe_path, O_WRONLY);
-  if (session.req_pipe == -1) {
-      perror("[ERR]: open(req_pipe_path) failed");
-      unlink(req_pipe_path);
-      unlink(notif_pipe_path);
-    return 1;
+  if (s->response[0] != OP_CODE_CONNECT || s->response[1] != 0) {
+    debug("[ERR]: server rejected connection\n");
+    s->state = SESSION_CLOSED;
+    return PACMAN_EVENT_CLOSED;
   }
+  s->state = SESSION_PLAYING;
+  return PACMAN_EVENT_CONNECTED;
+}
 
-  session.notif_pipe = open(notif_pipe_path, O_RDONLY);
-  if (session.notif_pipe == -1) {
-    perror("[ERR]: open(notif_pipe_path) failed");
-    close(session.req_pipe);
-    unlink(req_pipe_path);
-    unlink(notif_pipe_path);
-    return 1;
+pacman_event_t pacman_try_receive(pacman_session_t* s, const Board** board) {
+  if (s == NULL || s->state == SESSION_CLOSED) {
+    return PACMAN_EVENT_CLOSED;
+  }
+  if (s->state == SESSION_CONNECTING) {
+    return session_read_response(s);
   }
 
-  // Receber resposta do servidor
-  char response[2];
-  ssize_t bytes_read = 0;
-  ssize_t total_response_bytes = 2;
+  // O frame devolvido na chamada anterior deixa de ser válido
+  s->start += s->consumed;
+  s->consumed = 0;
 
-  while (bytes_read < total_response_bytes) {
-    ssize_t n = read(session.notif_pipe, response + bytes_read, total_response_bytes - bytes_read);
-    if (n == -1) {
-      perror("[ERR]: read(notif_pipe) failed");
-      close(session.req_pipe);
-      close(session.notif_pipe);
-      unlink(req_pipe_path);
-      unlink(notif_pipe_path);
-      return 1;
+  while (1) {
+    ssize_t length = frame_length(s->buf + s->start, s->end - s->start);
+    if (length < 0) {
+      debug("[ERR]: invalid frame from server\n");
+      s->state = SESSION_CLOSED;
+      return PACMAN_EVENT_CLOSED;
+    }
+    if (s->buf && s->end - s->start >= (size_t)length) {
+      decode_frame(s->buf + s->start, &s->board);
+      s->consumed = length;
+      if (board) *board = &s->board;
+      return PACMAN_EVENT_FRAME;
+    }
+    if (s->eof) {
+      s->state = SESSION_CLOSED;
+      return PACMAN_EVENT_CLOSED;
+    }
+
+    // Frame incompleto: compactar, garantir espaço para ele inteiro e ler o que houver
+    memmove(s->buf, s->buf + s->start, s->end - s->start);
+    s->end -= s->start;
+    s->start = 0;
+    size_t need = length > RECEIVER_MIN_CAPACITY ? (size_t)length : RECEIVER_MIN_CAPACITY;
+    if (s->capacity < need) {
+      char* buf = realloc(s->buf, need);
+      if (buf == NULL) {
+        s->state = SESSION_CLOSED;
+        return PACMAN_EVENT_CLOSED;
+      }
+      s->buf = buf;
+      s->capacity = need;
+    }
+
+    ssize_t n = read(s->notif_pipe, s->buf + s->end, s->capacity - s->end);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) return PACMAN_EVENT_NONE;
+      s->state = SESSION_CLOSED;
+      return PACMAN_EVENT_CLOSED;
     }
     if (n == 0) {
-      // Pipe fechado antes de receber resposta
-      perror("[ERR]: server closed connection before sending response");
-      close(session.req_pipe);
-      close(session.notif_pipe);
-      unlink(req_pipe_path);
-      unlink(notif_pipe_path);
-      return 1;
+      s->eof = 1;
     }
-    bytes_read += n;
+    s->end += n;
   }
+}
 
-  // Verificar resposta
-  if (response[0] != OP_CODE_CONNECT) {
-    perror("[ERR]: invalid OP_CODE in server response");
-    close(session.req_pipe);
-    close(session.notif_pipe);
-    unlink(req_pipe_path);
-    unlink(notif_pipe_path);
-    return 1;
+int pacman_session_play(pacman_session_t* s, char command) {
+  if (s == NULL || s->req_pipe < 0) {
+    debug("[WARN]: pacman_play() called without active session\n");
+    return -1;
   }
 
-  if (response[1] != 0) {
-    perror("[ERR]: server rejected connection");
-    close(session.req_pipe);
-    close(session.notif_pipe);
-    unlink(req_pipe_path);
-    unlink(notif_pipe_path);
-    return 1;
+  char msg[MSG_PLAY_SIZE];
+  msg[0] = OP_CODE_PLAY;
+  msg[1] = command;
+  if (write_all(s->req_pipe, msg, sizeof(msg)) != 0) {
+    debug("[ERR]: write(req_pipe) failed in pacman_play()\n");
+    return -1;
   }
-
-  // Sucesso - guardar ID da sessão (pode ser usado mais tarde)
-  session.id = 0;
-
-  (void)server_pipe_path;
   return 0;
 }
 
-void pacman_play(char command) {
-
-  if (session.id < 0 || session.req_pipe < 0) {
-    // Sessão não está ativa - retornar silenciosamente
-     debug("[WARN]: pacman_play() called without active session\n");
-    return;
+unsigned int pacman_session_play_seq(pacman_session_t* s, char command) {
+  if (s == NULL || s->req_pipe < 0) {
+    debug("[WARN]: pacman_play_seq() called without active session\n");
+    return 0;
   }
 
-  char msg[2];
-  msg[0] = OP_CODE_PLAY;
+  unsigned int seq = s->next_seq++;
+  if (s->next_seq == 0) s->next_seq = 1;  // 0 significa "nenhuma"
+
+  char msg[MSG_PLAY_SEQ_SIZE];
+  msg[0] = OP_CODE_PLAY_SEQ;
   msg[1] = command;
+  memcpy(msg + 2, &seq, 4);
+  if (write_all(s->req_pipe, msg, sizeof(msg)) != 0) {
+    debug("[ERR]: write(req_pipe) failed in pacman_play_seq()\n");
+    return 0;
+  }
+  return seq;
+}
 
-  ssize_t bytes_written = 0;
-  ssize_t total_bytes = 2;
+unsigned int pacman_session_play_batch(pacman_session_t* s, const char* cmds, size_t n) {
+  if (s == NULL || s->req_pipe < 0) {
+    debug("[WARN]: pacman_play_batch() called without active session\n");
+    return 0;
+  }
+  if (n == 0) {
+    return 0;
+  }
 
-  while (bytes_written < total_bytes) {
-    ssize_t n = write(session.req_pipe, msg + bytes_written, total_bytes - bytes_written);
-    if (n == -1 ) {
-      debug("[ERR]: write(req_pipe) failed in pacman_play()\n");
-      return;
+  // Números consecutivos: se o lote passasse pelo 0, recomeça em 1
+  if (s->next_seq + (unsigned int)n < s->next_seq) s->next_seq = 1;
+  unsigned int first = s->next_seq;
+  s->next_seq += (unsigned int)n;
+  if (s->next_seq == 0) s->next_seq = 1;
+
+  char msg[PLAY_BATCH_CHUNK * MSG_PLAY_SEQ_SIZE];
+  size_t sent = 0;
+  while (sent < n) {
+    size_t count = n - sent < PLAY_BATCH_CHUNK ? n - sent : PLAY_BATCH_CHUNK;
+    for (size_t i = 0; i < count; i++) {
+      unsigned int seq = first + (unsigned int)(sent + i);
+      char* p = msg + i * MSG_PLAY_SEQ_SIZE;
+      p[0] = OP_CODE_PLAY_SEQ;
+      p[1] = cmds[sent + i];
+      memcpy(p + 2, &seq, 4);
+    }
+    if (write_all(s->req_pipe, msg, count * MSG_PLAY_SEQ_SIZE) != 0) {
+      debug("[ERR]: write(req_pipe) failed in pacman_play_batch()\n");
+      return 0;
     }
-    bytes_written += n;
+    sent += count;
   }
-  
- 
+
+  return first;
 }
 
-int pacman_disconnect() {
-  if (session.req_pipe < 0) {
+int pacman_session_new_game(pacman_session_t* s, int mode) {
+  if (s == NULL || s->req_pipe < 0) {
+    debug("[WARN]: pacman_new_game() called without active session\n");
+    return -1;
+  }
+
+  char msg[MSG_NEW_GAME_SIZE];
+  msg[0] = OP_CODE_NEW_GAME;
+  msg[1] = (char)mode;
+  if (write_all(s->req_pipe, msg, sizeof(msg)) != 0) {
+    debug("[ERR]: write(req_pipe) failed in pacman_new_game()\n");
+    return -1;
+  }
+  return 0;
+}
+
+int pacman_session_disconnect(pacman_session_t* s) {
+  if (s == NULL || s->req_pipe < 0) {
     // Já desconectado - retornar sucesso
     return 0;
   }
 
   char msg = OP_CODE_DISCONNECT;
-  ssize_t bytes_written = 0;
-  ssize_t total_bytes = 1;
+  // Erro ao escrever - fechar o pipe mesmo assim
+  int result = write_all(s->req_pipe, &msg, 1) == 0 ? 0 : 1;
+  close(s->req_pipe);
+  s->req_pipe = -1;
+  return result;
+}
 
-  while (bytes_written < total_bytes) {
-    ssize_t n = write(session.req_pipe, &msg + bytes_written, total_bytes - bytes_written);
-    if (n == -1) {
-      // Erro ao escrever - continuar para fechar pipes mesmo assim
-      break;
-    }
-    bytes_written += n;
+void pacman_session_close(pacman_session_t* s) {
+  if (s == NULL) {
+    return;
+  }
+  if (s->state == SESSION_PLAYING) {
+    pacman_session_disconnect(s);
   }
+  if (s->req_pipe >= 0) close(s->req_pipe);
+  if (s->notif_pipe >= 0) close(s->notif_pipe);
+  session_unlink(s);
+  free(s->buf);
+  free(s);
+}
+
+// ========== API GLOBAL (BLOQUEANTE) ==========
 
-  if (session.req_pipe >= 0) {
-    close(session.req_pipe);
-    session.req_pipe = -1;
+int pacman_connect(char const *req_pipe_path, char const *notif_pipe_path, char const *server_pipe_path) {
+  pacman_session_t* s = pacman_session_open(req_pipe_path, notif_pipe_path, server_pipe_path);
+  if (s == NULL) {
+    return 1;
   }
 
-  if (session.notif_pipe >= 0) {
-    close(session.notif_pipe);
-    session.notif_pipe = -1;
+  // Receber resposta do servidor
+  pacman_event_t event;
+  while ((event = pacman_try_receive(s, NULL)) == PACMAN_EVENT_NONE) {
+    struct pollfd pfd = {.fd = s->notif_pipe, .events = POLLIN};
+    if (poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+      event = PACMAN_EVENT_CLOSED;
+      break;
+    }
+  }
+  if (event != PACMAN_EVENT_CONNECTED) {
+    fprintf(stderr, "[ERR]: server rejected or closed the connection\n");
+    pacman_session_close(s);
+    return 1;
   }
 
- 
-  unlink(session.req_pipe_path);
-  unlink(session.notif_pipe_path);
+  // As leituras desta API são bloqueantes
+  fcntl(s->notif_pipe, F_SETFL, fcntl(s->notif_pipe, F_GETFL) & ~O_NONBLOCK);
+  session = s;
+  return 0;
+}
 
- 
-  session.id = -1;
-  session.req_pipe = -1;  
-  session.notif_pipe = -1; 
-  session.req_pipe_path[0] = '\0';
-  session.notif_pipe_path[0] = '\0';
+void pacman_play(char command) {
+  pacman_session_play(session, command);
+}
 
-  return 0;
+unsigned int pacman_play_seq(char command) {
+  return pacman_session_play_seq(session, command);
+}
+
+unsigned int pacman_play_batch(const char* cmds, size_t n) {
+  return pacman_session_play_batch(session, cmds, n);
+}
+
+int pacman_new_game(int mode) {
+  return pacman_session_new_game(session, mode);
+}
+
+int pacman_disconnect() {
+  // A sessão continua viva: um recetor pode estar bloqueado no pipe de notificações
+  return pacman_session_disconnect(session);
+}
+
+void pacman_close(void) {
+  pacman_session_close(session);
+  session = NULL;
 }
 
 Board receive_board_update(void) {
 
-  if (session.notif_pipe < 0) {
+  if (session == NULL || session->notif_pipe < 0) {
     Board board = {0};
     board.game_over = 1;
     board.data = NULL;
     return board;
   }
 
-  char header[25];
+  char header[33];
   ssize_t bytes_read = 0;
   ssize_t total_header_bytes = 25;
 
   while (bytes_read < total_header_bytes) {
-    ssize_t n = read(session.notif_pipe, header + bytes_read, total_header_bytes - bytes_read);
+    ssize_t n = read(session->notif_pipe, header + bytes_read, total_header_bytes - bytes_read);
      if (n == -1) {
       // Erro na leitura
       Board board = {0};
@@ -269,7 +454,7 @@ Board receive_board_update(void) {
   }
 
   // Verificar OP_CODE
-  if (header[0] != OP_CODE_BOARD) {
+  if (header[0] != OP_CODE_BOARD && header[0] != OP_CODE_BOARD_SEQ) {
     // OP_CODE inválido
     Board board = {0};
     board.game_over = 1;
@@ -285,6 +470,24 @@ Board receive_board_update(void) {
   int game_over = *(int*)(header + 17);
   int accumulated_points = *(int*)(header + 21);
 
+  // OP_CODE_BOARD_SEQ: mais 8 bytes com a última sequência aplicada e o tick
+  int has_seq = header[0] == OP_CODE_BOARD_SEQ;
+  unsigned int last_seq = 0, tick = 0;
+  if (has_seq) {
+    while (bytes_read < 33) {
+      ssize_t n = read(session->notif_pipe, header + bytes_read, 33 - bytes_read);
+      if (n <= 0) {
+        Board board = {0};
+        board.game_over = 1;
+        board.data = NULL;
+        return board;
+      }
+      bytes_read += n;
+    }
+    memcpy(&last_seq, header + 25, 4);
+    memcpy(&tick, header + 29, 4);
+  }
+
   size_t data_size = width * height;
   char* data = malloc(data_size);
   if (data == NULL) {
@@ -301,7 +504,7 @@ Board receive_board_update(void) {
  
 
   while (bytes_read < total_data_bytes) {
-    ssize_t n = read(session.notif_pipe, data + bytes_read, total_data_bytes - bytes_read);
+    ssize_t n = read(session->notif_pipe, data + bytes_read, total_data_bytes - bytes_read);
     if (n == -1) {
       // Erro na leitura - libertar memória
       free(data);
@@ -348,8 +551,155 @@ Board receive_board_update(void) {
   board.game_over = game_over;
   board.accumulated_points = accumulated_points;
   board.data = data;
+  board.has_seq = has_seq;
+  board.last_seq = last_seq;
+  board.tick = tick;
   
  
  
   return board;
-}
\ No newline at end of file
+}
+
+void board_receiver_init(BoardReceiver* receiver) {
+  memset(receiver, 0, sizeof(*receiver));
+}
+
+void board_receiver_free(BoardReceiver* receiver) {
+  free(receiver->buf[0]);
+  free(receiver->buf[1]);
+  memset(receiver, 0, sizeof(*receiver));
+}
+
+static const Board* receiver_fail(BoardReceiver* receiver) {
+  memset(&receiver->board, 0, sizeof(Board));
+  receiver->board.game_over = 1;
+  receiver->board.data = NULL;
+  return &receiver->board;
+}
+
+// Garante pelo menos size bytes em buf[which] (cresce para o dobro)
+static int receiver_reserve(BoardReceiver* receiver, int which, size_t size) {
+  if (receiver->capacity[which] >= size && receiver->buf[which]) {
+    return 0;
+  }
+  size_t capacity = receiver->capacity[which] ? receiver->capacity[which] * 2 : RECEIVER_MIN_CAPACITY;
+  while (capacity < size) capacity *= 2;
+  char* buf = realloc(receiver->buf[which], capacity);
+  if (!buf) {
+    return -1;
+  }
+  receiver->buf[which] = buf;
+  receiver->capacity[which] = capacity;
+  return 0;
+}
+
+/* Tamanho do frame que começa em p: o total se o cabeçalho já chegou,
+senão o do cabeçalho; -1 se os bytes não forem um frame válido. */
+static ssize_t frame_length(const char* p, size_t available) {
+  if (available < 1) {
+    return 25;
+  }
+  if (p[0] != OP_CODE_BOARD && p[0] != OP_CODE_BOARD_SEQ) {
+    return -1;
+  }
+  size_t header = p[0] == OP_CODE_BOARD_SEQ ? 33 : 25;
+  if (available < header) {
+    return header;
+  }
+  int width, height;
+  memcpy(&width, p + 1, 4);
+  memcpy(&height, p + 5, 4);
+  if (width <= 0 || height <= 0 || width > 1000 || height > 1000) {
+    return -1;
+  }
+  return header + (size_t)width * height;
+}
+
+/* Preenche board a partir de um frame completo (data aponta para o frame). */
+static void decode_frame(const char* frame, Board* board) {
+  memcpy(&board->width, frame + 1, 4);
+  memcpy(&board->height, frame + 5, 4);
+  memcpy(&board->tempo, frame + 9, 4);
+  memcpy(&board->victory, frame + 13, 4);
+  memcpy(&board->game_over, frame + 17, 4);
+  memcpy(&board->accumulated_points, frame + 21, 4);
+  board->has_seq = frame[0] == OP_CODE_BOARD_SEQ;
+  board->last_seq = 0;
+  board->tick = 0;
+  if (board->has_seq) {
+    memcpy(&board->last_seq, frame + 25, 4);
+    memcpy(&board->tick, frame + 29, 4);
+  }
+  board->data = (char*)frame + (board->has_seq ? 33 : 25);
+}
+
+const Board* receive_board_latest(BoardReceiver* receiver) {
+  if (session == NULL || session->notif_pipe < 0) {
+    return receiver_fail(receiver);
+  }
+
+  // Os bytes por consumir passam para o outro buffer: o frame devolvido antes fica intacto
+  int back = 1 - receiver->front;
+  size_t end = receiver->end - receiver->start;
+  if (receiver_reserve(receiver, back, end) != 0) {
+    return receiver_fail(receiver);
+  }
+  if (end > 0) {
+    memcpy(receiver->buf[back], receiver->buf[receiver->front] + receiver->start, end);
+  }
+
+  size_t pos = 0;
+  ssize_t latest = -1;  // Offset do frame completo mais recente
+  unsigned long parsed = 0;
+
+  while (1) {
+    char* buf = receiver->buf[back];
+    ssize_t length;
+    while ((length = frame_length(buf + pos, end - pos)) > 0 && end - pos >= (size_t)length) {
+      latest = pos;
+      pos += length;
+      parsed++;
+    }
+    if (length < 0) {
+      debug("[ERR]: invalid frame from server\n");
+      return receiver_fail(receiver);
+    }
+
+    if (latest >= 0) {
+      // Já há um frame: ler só o que o pipe já tiver
+      struct pollfd pfd = {.fd = session->notif_pipe, .events = POLLIN};
+      if (receiver->eof || end == receiver->capacity[back] || poll(&pfd, 1, 0) <= 0) {
+        break;
+      }
+    } else {
+      if (receiver->eof) {
+        return receiver_fail(receiver);
+      }
+      if (receiver_reserve(receiver, back, pos + length) != 0) {
+        return receiver_fail(receiver);
+      }
+    }
+
+    ssize_t n = read(session->notif_pipe, receiver->buf[back] + end, receiver->capacity[back] - end);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      if (latest < 0) return receiver_fail(receiver);
+      break;
+    }
+    if (n == 0) {
+      receiver->eof = 1;  // Entregar o que já chegou; a próxima chamada reporta o fim
+      if (latest < 0) return receiver_fail(receiver);
+      break;
+    }
+    end += n;
+  }
+
+  receiver->front = back;
+  receiver->start = pos;
+  receiver->end = end;
+  receiver->frames += parsed;
+  receiver->skipped += parsed - 1;
+
+  decode_frame(receiver->buf[back] + latest, &receiver->board);
+  return &receiver->board;
+}
@@ -2,6 +2,8 @@
 #include "protocol.h"
 #include "client_display.h"
 #include "debug.h"
+#include "latency.h"
+#include "predict.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -11,34 +13,181 @@
 #include <stdbool.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <time.h>
+#include <signal.h>
+#include <errno.h>
+
+#define PENDING_INPUTS 256      // Jogadas à espera de frame (índice seq % PENDING_INPUTS)
+#define SCRIPT_WAIT_MS 100      // Espera máxima por um tick enquanto o tempo do nível não é conhecido
 
 Board board;
 bool stop_execution = false;
 int tempo;
 pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// Latência jogada -> primeiro frame que a reflete (protegido por mutex)
+uint64_t sent_us[PENDING_INPUTS];
+unsigned int last_sent_seq = 0;
+unsigned int last_acked_seq = 0;
+latency_hist_t input_latency;
+
+// Controlo de fluxo do modo scripted: ticks ecoados pelo servidor (protegido por mutex)
+pthread_cond_t ack_cond = PTHREAD_COND_INITIALIZER;
+unsigned int server_tick = 0;  // Tick do último frame com sequência
+unsigned int sent_tick = 0;    // server_tick quando a última jogada foi enviada
+
+// Previsão local (PACMAN_PREDICT=1): o predictor e o desenho são protegidos por display_mutex
+pthread_mutex_t display_mutex = PTHREAD_MUTEX_INITIALIZER;
+bool predict = false;
+predictor_t predictor;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/* Regista a latência das jogadas que o frame passou a refletir. */
+static void ack_inputs(Board* frame) {
+    if (!frame->has_seq) {
+        return;
+    }
+
+    uint64_t now = now_us();
+    pthread_mutex_lock(&mutex);
+    unsigned int acked = frame->last_seq;
+    if (acked > last_sent_seq) acked = last_sent_seq;
+    for (unsigned int seq = last_acked_seq + 1; seq <= acked && acked > last_acked_seq; seq++) {
+        // Jogadas mais antigas do que o anel já foram sobrescritas
+        if (last_sent_seq - seq < PENDING_INPUTS) {
+            latency_record(&input_latency, now - sent_us[seq % PENDING_INPUTS]);
+        }
+    }
+    if (acked > last_acked_seq) last_acked_seq = acked;
+    server_tick = frame->tick;
+    pthread_cond_broadcast(&ack_cond);
+    pthread_mutex_unlock(&mutex);
+}
+
+/* Espera que o servidor aplique a última jogada e avance pelo menos um tick.
+O servidor aplica cada jogada mal a lê, por isso só se envia uma por tick,
+mesmo que tenham passado vários: um lote moveria o pacman várias células num
+tick. Se não chegar frame dentro do tempo do nível (ex.: nenhum ghost age),
+conta como um tick. */
+static void wait_for_tick(void) {
+    pthread_mutex_lock(&mutex);
+    int wait_ms = tempo > 0 ? tempo : SCRIPT_WAIT_MS;
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += wait_ms / 1000;
+    deadline.tv_nsec += (long)(wait_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    while (!stop_execution && (last_acked_seq != last_sent_seq || server_tick == sent_tick)) {
+        if (pthread_cond_timedwait(&ack_cond, &mutex, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+/* Lê até max comandos do ficheiro (recomeça no fim). *quit fica a 1 num 'Q'. */
+static size_t read_script(FILE* cmd_fp, char* cmds, size_t max, int* quit) {
+    size_t n = 0;
+    int rewound = 0;
+    while (n < max) {
+        int ch = fgetc(cmd_fp);
+        if (ch == EOF) {
+            // Restart at the start of the file (um ficheiro sem comandos não fica em ciclo)
+            if (rewound) break;
+            rewind(cmd_fp);
+            rewound = 1;
+            continue;
+        }
+        if (ch == '\n' || ch == '\r' || ch == '\0') {
+            continue;
+        }
+        rewound = 0;
+        char command = toupper((char)ch);
+        if (command == 'Q') {
+            *quit = 1;
+            break;
+        }
+        cmds[n++] = command;
+    }
+    return n;
+}
+
+/* Envia os comandos e regista a hora de envio de cada um (latência). Com
+previsão, desenha já o resultado local. */
+static void send_commands(const char* cmds, size_t n) {
+    // Com display_mutex, o recetor não reconcilia um frame antes de as jogadas entrarem no predictor
+    pthread_mutex_lock(&display_mutex);
+
+    // Com o mutex, o recetor não processa o frame antes de o envio ficar registado
+    pthread_mutex_lock(&mutex);
+    uint64_t sent_at = now_us();
+    unsigned int first = n == 1 ? pacman_play_seq(cmds[0]) : pacman_play_batch(cmds, n);
+    if (first != 0) {
+        for (size_t i = 0; i < n; i++) {
+            sent_us[(first + i) % PENDING_INPUTS] = sent_at;
+        }
+        last_sent_seq = first + (unsigned int)n - 1;
+        sent_tick = server_tick;
+    }
+    pthread_mutex_unlock(&mutex);
+
+    if (predict && first != 0) {
+        const Board* shown = NULL;
+        for (size_t i = 0; i < n; i++) {
+            const Board* predicted = predictor_input(&predictor, cmds[i], first + (unsigned int)i);
+            if (predicted) shown = predicted;
+        }
+        if (shown) {
+            draw_board_client(*shown);
+            refresh_screen();
+        }
+    }
+    pthread_mutex_unlock(&display_mutex);
+}
+
 static void *receiver_thread(void *arg) {
     (void)arg;
 
+    // Desenha só o frame mais recente: se o terminal atrasar, os intermédios são descartados
+    BoardReceiver receiver;
+    board_receiver_init(&receiver);
+
     while (true) {
         
-        Board board = receive_board_update();
+        const Board* frame = receive_board_latest(&receiver);
 
-        if (!board.data || board.game_over == 1){
+        if (!frame->data || frame->game_over == 1){
             pthread_mutex_lock(&mutex);
             stop_execution = true;
             pthread_mutex_unlock(&mutex);
             break;
         }
 
+        Board board = *frame;
+        ack_inputs(&board);
+
         pthread_mutex_lock(&mutex);
         tempo = board.tempo;
         pthread_mutex_unlock(&mutex);
 
-        draw_board_client(board);
+        pthread_mutex_lock(&display_mutex);
+        const Board* shown = predict ? predictor_frame(&predictor, frame) : frame;
+        draw_board_client(*shown);
         refresh_screen();
+        pthread_mutex_unlock(&display_mutex);
     }
 
+    debug("Receiver: %lu frames, %lu skipped\n", receiver.frames, receiver.skipped);
+    board_receiver_free(&receiver);
     debug("Returning receiver thread...\n");
     return NULL;
 }
@@ -74,6 +223,13 @@ int main(int argc, char *argv[]) {
              "/tmp/%s_notification", client_id);
 
     open_debug_file("client-debug.log");
+    // O servidor fecha os pipes no fim do jogo; jogadas em curso falham com EPIPE em vez de terminar o cliente
+    signal(SIGPIPE, SIG_IGN);
+    latency_init(&input_latency);
+
+    const char* predict_env = getenv(PREDICT_ENV);
+    predict = predict_env && *predict_env && strcmp(predict_env, "0") != 0;
+    predictor_init(&predictor);
 
     if (pacman_connect(req_pipe_path, notif_pipe_path, register_pipe) != 0) {
         perror("Failed to connect to server");
@@ -89,7 +245,6 @@ int main(int argc, char *argv[]) {
     refresh_screen();
 
     char command;
-    int ch;
 
     while (1) {
 
@@ -101,35 +256,28 @@ int main(int argc, char *argv[]) {
         pthread_mutex_unlock(&mutex);
 
         if (cmd_fp) {
-            // Input from file
-            ch = fgetc(cmd_fp);
-
-            if (ch == EOF) {
-                // Restart at the start of the file
-                rewind(cmd_fp);
-                continue;
+            // Input from file: uma jogada por tick ecoado pelo servidor, não por sleeps
+            wait_for_tick();
+            int quit = 0;
+            size_t n = read_script(cmd_fp, &command, 1, &quit);
+            if (n > 0) {
+                debug("Command: %c\n", command);
+                send_commands(&command, 1);
             }
-
-            command = (char)ch;
-
-            if (command == '\n' || command == '\r' || command == '\0')
-                continue;
-
-            command = toupper(command);
-            
-            // Wait for tempo, to not overflow pipe with requests
-            pthread_mutex_lock(&mutex);
-            int wait_for = tempo;
-            pthread_mutex_unlock(&mutex);
-
-            sleep_ms(wait_for);
-            
-        } else {
-            // Interactive input
-            command = get_input();
-            command = toupper(command);
+            if (quit) {
+                debug("Commands file requested 'Q', quitting game\n");
+                break;
+            }
+            if (n == 0) {
+                break;  // Ficheiro sem comandos
+            }
+            continue;
         }
 
+        // Interactive input
+        command = get_input();
+        command = toupper(command);
+
         if (command == '\0')
             continue;
 
@@ -139,19 +287,31 @@ int main(int argc, char *argv[]) {
         }
 
         debug("Command: %c\n", command);
-
-        pacman_play(command);
-
+        send_commands(&command, 1);
     }
 
+    pthread_mutex_lock(&mutex);
+    latency_log(&input_latency, "Input->frame latency (us)");
+    pthread_mutex_unlock(&mutex);
+
     pacman_disconnect();
 
+    // O recetor lê o pipe de notificações até o servidor o fechar; só depois se liberta a sessão
     pthread_join(receiver_thread_id, NULL);
+    pacman_close();
+
+    if (predict) {
+        debug("Prediction: %lu moves confirmed by the server, %lu corrected\n",
+              predictor.predicted, predictor.corrected);
+    }
+    predictor_free(&predictor);
 
     if (cmd_fp)
         fclose(cmd_fp);
 
     pthread_mutex_destroy(&mutex);
+    pthread_cond_destroy(&ack_cond);
+    pthread_mutex_destroy(&display_mutex);
 
     terminal_cleanup();
 
@@ -15,6 +15,10 @@ void close_debug_file() {
 }
 
 void debug(const char * format, ...) {
+    // Sem ficheiro aberto (ex.: loadgen ligado à API do cliente) não há debug
+    if (!debugfile) {
+        return;
+    }
     va_list args;
     va_start(args, format);
     vfprintf(debugfile, format, args);
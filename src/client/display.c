@@ -1,11 +1,46 @@
 #include "client_display.h"
 #include "board.h"
 #include "api.h"
+#include "ansi.h"
+#include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
-
+#include <string.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+// Backend ANSI (PACMAN_RENDER=ansi): ecrã próprio e terminal em modo raw em vez do ncurses
+static int use_ansi = 0;
+static ansi_screen_t screen;
+static struct termios saved_termios;
+static int termios_saved = 0;
+static int input_timeout_ms = 1000;
+
+/* Lê teclas sem esperar pelo Enter e sem eco, como cbreak()/noecho(). */
+static void ansi_terminal_init(void) {
+    if (ansi_init(&screen, STDOUT_FILENO, getenv(ANSI_CAST_ENV)) != 0) {
+        perror("Failed to open " ANSI_CAST_ENV " recording");
+    }
+    if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved_termios) == 0) {
+        struct termios raw = saved_termios;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+        termios_saved = 1;
+    }
+}
 
 int terminal_init() {
+    const char* render = getenv(ANSI_RENDER_ENV);
+    if (render && strcmp(render, "ansi") == 0) {
+        use_ansi = 1;
+        ansi_terminal_init();
+        return 0;
+    }
+
     // Initialize ncurses mode
     initscr();
 
@@ -47,86 +82,161 @@ int terminal_init() {
 }
 
 
-void draw_board_client(Board board) {
-    // Clear the screen before redrawing
-    clear();
-
-    // Draw the border/title
-    attron(COLOR_PAIR(5));
-    mvprintw(0, 0, "=== PACMAN GAME ===");
-    if (board.game_over) {
-        mvprintw(1, 0, " GAME OVER ");
-    } else if (board.victory) {
-        mvprintw(1, 0, " VICTORY ");
-    } else {
-        mvprintw(1, 0, " Use W/A/S/D to move | Q to quit");
+// Último frame desenhado por draw_board_client (só a thread recetora desenha frames)
+static char* drawn_cells = NULL;
+static int drawn_width = 0;
+static int drawn_height = 0;
+static int drawn_status = -1;          // 0 = a jogar, 1 = game over, 2 = vitória
+static int drawn_points = -1;
+static chtype* span_buf = NULL;        // Uma linha de chtype (carácter + cor) para mvaddchnstr
+
+#define BOARD_START_ROW 3              // Linhas acima do tabuleiro reservadas para a UI
+
+// Carácter e atributos (par de cor + ANSI_BOLD/ANSI_DIM) de uma célula do frame
+static int cell_style(char ch, char* out) {
+    switch (ch) {
+        case '#': *out = '#'; return 3;                          // Wall
+        case 'C': *out = 'C'; return 1 | ANSI_BOLD;              // Pacman
+        case 'M': *out = 'M'; return 2 | ANSI_BOLD;              // Monster/Ghost
+        case 'G': *out = 'M'; return 2 | ANSI_BOLD | ANSI_DIM;   // Charged Monster/Ghost
+        case '.': *out = '.'; return 4;                          // Dot
+        case '@': *out = '@'; return 6;                          // Portal
+        default: *out = ch; return 0;
     }
+}
 
-    // Starting row for the game board (leave space for UI)
-    int start_row = 3;
-
-    // Draw the board
-    for (int y = 0; y < board.height; y++) {
-        for (int x = 0; x < board.width; x++) {
-            char ch = board.data[y * board.width + x];
+// O mesmo estilo como chtype do ncurses (a cor vai embutida)
+static chtype cell_chtype(char ch) {
+    char out;
+    int attr = cell_style(ch, &out);
+    chtype cell = (chtype)(unsigned char)out;
+    if (attr & ANSI_COLOUR_MASK) cell |= COLOR_PAIR(attr & ANSI_COLOUR_MASK);
+    if (attr & ANSI_BOLD) cell |= A_BOLD;
+    if (attr & ANSI_DIM) cell |= A_DIM;
+    return cell;
+}
 
-            // Move cursor to position
-            move(start_row + y, x);
+static void clear_screen(void) {
+    if (use_ansi) {
+        ansi_clear(&screen);
+    } else {
+        clear();
+    }
+}
 
-            // Draw with appropriate color
-            switch (ch) {
-                case '#': // Wall
-                    attron(COLOR_PAIR(3));
-                    addch('#');
-                    attroff(COLOR_PAIR(3));
-                    break;
+/* Substitui a linha row por texto da UI (verde). */
+static void print_line(int row, const char* format, ...) __attribute__((format(printf, 2, 3)));
 
-                case 'C': // Pacman
-                    attron(COLOR_PAIR(1) | A_BOLD);
-                    addch('C');
-                    attroff(COLOR_PAIR(1) | A_BOLD);
-                    break;
+static void print_line(int row, const char* format, ...) {
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
 
-                case 'M': // Monster/Ghost
-                    attron(COLOR_PAIR(2) | A_BOLD);
-                    addch('M');
-                    attroff(COLOR_PAIR(2) | A_BOLD);  
-                    break;
+    if (use_ansi) {
+        ansi_clear_line(&screen, row, 0);
+        ansi_print(&screen, row, 0, 5, "%s", text);
+        return;
+    }
+    attron(COLOR_PAIR(5));
+    move(row, 0);
+    clrtoeol();
+    mvaddstr(row, 0, text);
+    attroff(COLOR_PAIR(5));
+}
 
-                case 'G': // Charged Monster/Ghost
-                    attron((COLOR_PAIR(2) | A_BOLD) | A_DIM);
-                    addch('M');
-                    attroff((COLOR_PAIR(2) | A_BOLD) | A_DIM);  
-                    break;
+static void draw_status(Board* board) {
+    // O último nível acaba com victory e game_over: mostra-se a vitória
+    int status = board->victory ? 2 : board->game_over ? 1 : 0;
+    if (status == drawn_status) {
+        return;
+    }
+    if (status == 1) {
+        print_line(1, " GAME OVER ");
+    } else if (status == 2) {
+        print_line(1, " VICTORY ");
+    } else {
+        print_line(1, " Use W/A/S/D to move | Q to quit");
+    }
+    drawn_status = status;
+}
 
-                case '.': // Dot
-                    attron(COLOR_PAIR(4));
-                    addch('.');
-                    attroff(COLOR_PAIR(4));
-                    break;
+static void draw_points(Board* board) {
+    if (board->accumulated_points == drawn_points) {
+        return;
+    }
+    print_line(BOARD_START_ROW + board->height + 1, "Points: %d", board->accumulated_points);
+    drawn_points = board->accumulated_points;
+}
 
-                case '@': // Portal
-                    attron(COLOR_PAIR(6));
-                    addch('@');
-                    attroff(COLOR_PAIR(6));
-                    break;
+/* Desenha as células de [from, to) da linha y numa só chamada. */
+static void draw_span(Board* board, int y, int from, int to) {
+    const char* row = board->data + y * board->width;
+    if (use_ansi) {
+        for (int x = from; x < to; x++) {
+            char ch;
+            int attr = cell_style(row[x], &ch);
+            ansi_put(&screen, BOARD_START_ROW + y, x, ch, attr);
+        }
+        return;
+    }
+    for (int x = from; x < to; x++) {
+        span_buf[x - from] = cell_chtype(row[x]);
+    }
+    mvaddchnstr(BOARD_START_ROW + y, from, span_buf, to - from);
+}
 
-                case ' ': // Empty space
-                    addch(' ');
-                    break;
+/* Redesenha só as células que mudaram desde o frame anterior, uma chamada
+por troço de células alteradas (a cor vai em cada chtype). O ecrã só é
+limpo quando o tamanho do tabuleiro muda. */
+void draw_board_client(Board board) {
+    if (!board.data) {
+        // Ainda sem frame: só o título
+        print_line(0, "=== PACMAN GAME ===");
+        return;
+    }
 
-                default:
-                    addch(ch);
-                    break;
+    int cells = board.width * board.height;
+    int full = board.width != drawn_width || board.height != drawn_height || !drawn_cells;
+    if (full) {
+        char* resized = realloc(drawn_cells, cells);
+        chtype* line = realloc(span_buf, (board.width + 1) * sizeof(chtype));
+        if (resized) drawn_cells = resized;
+        if (line) span_buf = line;
+        if (!resized || !line) {
+            return;
+        }
+        drawn_width = board.width;
+        drawn_height = board.height;
+        drawn_status = -1;
+        drawn_points = -1;
+
+        clear_screen();
+        print_line(0, "=== PACMAN GAME ===");
+        for (int y = 0; y < board.height; y++) {
+            draw_span(&board, y, 0, board.width);
+        }
+    } else {
+        for (int y = 0; y < board.height; y++) {
+            const char* row = board.data + y * board.width;
+            const char* old = drawn_cells + y * board.width;
+            int x = 0;
+            while (x < board.width) {
+                if (row[x] == old[x]) {
+                    x++;
+                    continue;
+                }
+                int from = x;
+                while (x < board.width && row[x] != old[x]) x++;
+                draw_span(&board, y, from, x);
             }
         }
     }
+    memcpy(drawn_cells, board.data, cells);
 
-    // Draw score/status at the bottom
-    attron(COLOR_PAIR(5));
-    mvprintw(start_row + board.height + 1, 0, "Points: %d",
-             board.accumulated_points);
-    attroff(COLOR_PAIR(5));
+    draw_status(&board);
+    draw_points(&board);
 }
 
 // Does exaclty the same as draw board but stores the output in a string instead of printing it
@@ -189,7 +299,39 @@ char* get_board_displayed(board_t* board) {
     return output;
 }
 
+// draw_board no backend ANSI, a partir dos caracteres de get_board_displayed
+static void draw_board_ansi(board_t* board, int mode) {
+    char* cells = get_board_displayed(board);
+    if (!cells) {
+        return;
+    }
+    ansi_clear(&screen);
+    ansi_print(&screen, 0, 0, 5, "=== PACMAN GAME ===");
+    switch (mode) {
+        case DRAW_GAME_OVER: ansi_print(&screen, 1, 0, 5, " GAME OVER "); break;
+        case DRAW_WIN: ansi_print(&screen, 1, 0, 5, " VICTORY "); break;
+        case DRAW_MENU:
+            ansi_print(&screen, 1, 0, 5, "Level: %s | Use W/A/S/D to move | Q to quit | G to quicksave ",
+                       board->level_name);
+            break;
+    }
+    for (int y = 0; y < board->height; y++) {
+        for (int x = 0; x < board->width; x++) {
+            char ch;
+            int attr = cell_style(cells[y * board->width + x], &ch);
+            ansi_put(&screen, BOARD_START_ROW + y, x, ch, attr);
+        }
+    }
+    ansi_print(&screen, BOARD_START_ROW + board->height + 1, 0, 5, "Points: %d", board->pacmans[0].points);
+    free(cells);
+}
+
 void draw_board(board_t* board, int mode) {
+    if (use_ansi) {
+        draw_board_ansi(board, mode);
+        return;
+    }
+
     // Clear the screen before redrawing
     clear();
 
@@ -283,6 +425,10 @@ void draw_board(board_t* board, int mode) {
 }
 
 void draw(char c, int colour_i, int pos_x, int pos_y) {
+    if (use_ansi) {
+        ansi_put(&screen, pos_y, pos_x, c, (colour_i & ANSI_COLOUR_MASK) | ANSI_BOLD);
+        return;
+    }
     move(pos_y, pos_x);
     attron(COLOR_PAIR(colour_i) | A_BOLD);
     addch(c);
@@ -291,12 +437,29 @@ void draw(char c, int colour_i, int pos_x, int pos_y) {
 
 void refresh_screen() {
     // Update the physical screen with the virtual screen
+    if (use_ansi) {
+        ansi_refresh(&screen);
+        return;
+    }
     refresh();
 }
 
+/* Espera até input_timeout_ms por uma tecla no stdin (equivalente ao getch() com timeout). */
+static int ansi_getch(void) {
+    struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+    if (poll(&pfd, 1, input_timeout_ms) <= 0) {
+        return ERR;
+    }
+    unsigned char ch;
+    if (read(STDIN_FILENO, &ch, 1) != 1) {
+        return ERR;
+    }
+    return ch;
+}
+
 char get_input() {
     // Get a character from the keyboard
-    int ch = getch();
+    int ch = use_ansi ? ansi_getch() : getch();
 
     // getch() returns ERR if no input is available
     if (ch == ERR) {
@@ -322,9 +485,20 @@ char get_input() {
 
 void terminal_cleanup() {
     // Restore terminal settings and clean up ncurses
+    if (use_ansi) {
+        ansi_end(&screen);
+        if (termios_saved) {
+            tcsetattr(STDIN_FILENO, TCSANOW, &saved_termios);
+            termios_saved = 0;
+        }
+        return;
+    }
     endwin();
 }
 
 void set_timeout(int timeout_ms) {
-    timeout(timeout_ms);
+    input_timeout_ms = timeout_ms;
+    if (!use_ansi) {
+        timeout(timeout_ms);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "latency.h"
+#include "debug.h"
+#include <string.h>
+
+static int bucket_index(uint64_t value) {
+    if (value < LATENCY_SUB_BUCKETS) {
+        return (int)value;
+    }
+    int exp = 63 - __builtin_clzll(value);
+    int sub = (int)(value >> (exp - LATENCY_SUB_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+    return (exp - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS + sub;
+}
+
+// Intervalo [low, high] de valores de um bucket
+static void bucket_range(int index, uint64_t* low, uint64_t* high) {
+    if (index < LATENCY_SUB_BUCKETS) {
+        *low = *high = (uint64_t)index;
+        return;
+    }
+    int exp = index / LATENCY_SUB_BUCKETS + LATENCY_SUB_BITS - 1;
+    int sub = index % LATENCY_SUB_BUCKETS;
+    uint64_t width = 1ULL << (exp - LATENCY_SUB_BITS);
+    *low = (uint64_t)(LATENCY_SUB_BUCKETS + sub) * width;
+    *high = *low + width - 1;
+}
+
+void latency_init(latency_hist_t* hist) {
+    memset(hist, 0, sizeof(*hist));
+}
+
+void latency_record(latency_hist_t* hist, uint64_t value) {
+    if (value > UINT32_MAX) value = UINT32_MAX;
+
+    hist->counts[bucket_index(value)]++;
+    if (hist->total == 0 || value < hist->min) hist->min = value;
+    if (value > hist->max) hist->max = value;
+    hist->sum += value;
+    hist->total++;
+}
+
+uint64_t latency_percentile(latency_hist_t* hist, double percentile) {
+    if (hist->total == 0) {
+        return 0;
+    }
+    unsigned long target = (unsigned long)(percentile / 100.0 * hist->total + 0.5);
+    if (target < 1) target = 1;
+
+    unsigned long seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= target) {
+            uint64_t low, high;
+            bucket_range(i, &low, &high);
+            return high < hist->max ? high : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+void latency_log(latency_hist_t* hist, const char* label) {
+    if (hist->total == 0) {
+        debug("%s: no samples\n", label);
+        return;
+    }
+
+    debug("%s: n=%lu min=%llu mean=%llu p50=%llu p90=%llu p99=%llu p99.9=%llu max=%llu\n",
+          label, hist->total, (unsigned long long)hist->min,
+          (unsigned long long)(hist->sum / hist->total),
+          (unsigned long long)latency_percentile(hist, 50.0),
+          (unsigned long long)latency_percentile(hist, 90.0),
+          (unsigned long long)latency_percentile(hist, 99.0),
+          (unsigned long long)latency_percentile(hist, 99.9),
+          (unsigned long long)hist->max);
+
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        if (hist->counts[i] == 0) continue;
+        uint64_t low, high;
+        bucket_range(i, &low, &high);
+        debug("  [%llu, %llu] %lu\n", (unsigned long long)low, (unsigned long long)high,
+              hist->counts[i]);
+    }
+}
@@ -0,0 +1,247 @@
+#include "predict.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Resultado de uma jogada segundo as regras de move_pacman
+enum {
+    STEP_NONE,      // T, comando inválido ou fora do tabuleiro: o waiting não muda
+    STEP_WALL,      // Parede: consome a jogada sem mover
+    STEP_FREE,      // Célula livre (com ou sem ponto)
+    STEP_UNKNOWN,   // Ghost ou portal: morte ou fim de nível, decide o servidor
+};
+
+static int find_pacman(const char* cells, int size) {
+    for (int i = 0; i < size; i++) {
+        if (cells[i] == 'C') return i;
+    }
+    return -1;
+}
+
+static int step_target(const predictor_t* predictor, const char* cells, int pos, char command, int* target) {
+    int x = pos % predictor->width;
+    int y = pos / predictor->width;
+    switch (command) {
+        case 'W': y--; break;
+        case 'S': y++; break;
+        case 'A': x--; break;
+        case 'D': x++; break;
+        default: return STEP_NONE;
+    }
+    if (x < 0 || y < 0 || x >= predictor->width || y >= predictor->height) {
+        return STEP_NONE;
+    }
+    *target = y * predictor->width + x;
+    switch (cells[*target]) {
+        case '#': return STEP_WALL;
+        case 'M': case 'G': case '@': return STEP_UNKNOWN;
+        default: return STEP_FREE;
+    }
+}
+
+/* Aplica command ao modelo como move_pacman: com waiting > 0 a jogada só o
+decrementa; com waiting == 0 reinicia-o a PASSO e move se não for parede.
+Se cells não for NULL, o movimento é desenhado nele. Devolve 0 se o
+resultado não é previsível (o modelo fica como estava). */
+static int model_step(const predictor_t* predictor, const char* lookup, char* cells, predict_model_t* model,
+                      char command) {
+    if (model->pos < 0) {
+        return 0;
+    }
+    int target;
+    int kind = step_target(predictor, lookup, model->pos, command, &target);
+    if (kind == STEP_NONE) {
+        return 1;
+    }
+    if (kind == STEP_UNKNOWN || model->waiting < 0) {
+        return 0;
+    }
+
+    if (model->waiting > 0) {
+        model->waiting--;
+        if (model->since_move >= 0) model->since_move++;
+        return 1;
+    }
+    model->waiting = predictor->passo;
+    model->since_move = 0;
+    if (kind == STEP_FREE) {
+        if (cells) {
+            if (cells[target] == '.') model->points++;
+            cells[model->pos] = ' ';
+            cells[target] = 'C';
+        }
+        model->pos = target;
+    }
+    return 1;
+}
+
+/* Aprende com um frame que confirmou uma só jogada, vendo se o pacman se
+moveu (o servidor não envia o waiting nem o PASSO). */
+static void observe(predictor_t* predictor, char command, int new_pos) {
+    predict_model_t* model = &predictor->base_model;
+    int target;
+    int kind = model->pos < 0 ? STEP_UNKNOWN : step_target(predictor, predictor->base, model->pos, command, &target);
+
+    if (kind == STEP_NONE) {
+        return;
+    }
+    if (kind == STEP_UNKNOWN || new_pos < 0) {
+        model->waiting = -1;
+        model->since_move = -1;
+        return;
+    }
+
+    if (kind == STEP_FREE && new_pos == target) {
+        // Moveu: o waiting foi reiniciado e as esperas desde o último reinício são o PASSO
+        if (model->since_move >= 0) predictor->passo = model->since_move;
+        model->waiting = predictor->passo;
+        model->since_move = 0;
+    } else if (new_pos != model->pos) {
+        model->waiting = -1;
+        model->since_move = -1;
+    } else if (kind == STEP_FREE) {
+        // Não moveu para uma célula livre: estava em espera
+        if (model->since_move >= 0) model->since_move++;
+        if (predictor->passo >= 0 && model->since_move > predictor->passo) predictor->passo = -1;
+        model->waiting = model->waiting > 0 ? model->waiting - 1 : -1;
+    } else if (model->waiting > 0) {
+        // Parede: espera ou reinício, conforme o waiting que o modelo conhecia
+        model->waiting--;
+        if (model->since_move >= 0) model->since_move++;
+    } else if (model->waiting == 0) {
+        model->waiting = predictor->passo;
+        model->since_move = 0;
+    } else {
+        model->since_move = -1;
+    }
+
+    if (model->waiting < 0 && predictor->passo >= 0 && model->since_move >= 0 &&
+        model->since_move <= predictor->passo) {
+        model->waiting = predictor->passo - model->since_move;
+    }
+}
+
+/* Refaz cells a partir do base com todas as jogadas pendentes. */
+static void replay_pending(predictor_t* predictor) {
+    memcpy(predictor->cells, predictor->base, (size_t)predictor->width * predictor->height);
+    predictor->tip = predictor->base_model;
+    predictor->stalled = predictor->tip.pos < 0;
+    for (int i = 0; i < predictor->n_pending; i++) {
+        predict_input_t* input = &predictor->pending[i];
+        if (!predictor->stalled &&
+            !model_step(predictor, predictor->cells, predictor->cells, &predictor->tip, input->command)) {
+            predictor->stalled = 1;
+        }
+        input->predicted_pos = predictor->stalled ? -1 : predictor->tip.pos;
+    }
+    predictor->board.accumulated_points = predictor->tip.points;
+}
+
+void predictor_init(predictor_t* predictor) {
+    memset(predictor, 0, sizeof(*predictor));
+    predictor->passo = -1;
+    predictor->base_model.pos = -1;
+    predictor->stalled = 1;
+}
+
+void predictor_free(predictor_t* predictor) {
+    free(predictor->base);
+    free(predictor->cells);
+    predictor_init(predictor);
+}
+
+const Board* predictor_input(predictor_t* predictor, char command, unsigned int seq) {
+    if (!predictor->cells || predictor->n_pending == PREDICT_MAX_PENDING) {
+        return NULL;
+    }
+
+    predict_input_t* input = &predictor->pending[predictor->n_pending++];
+    input->command = command;
+    input->seq = seq;
+    input->predicted_pos = -1;
+    if (predictor->stalled) {
+        return NULL;
+    }
+
+    int old_pos = predictor->tip.pos;
+    if (!model_step(predictor, predictor->cells, predictor->cells, &predictor->tip, command)) {
+        predictor->stalled = 1;
+        return NULL;
+    }
+    input->predicted_pos = predictor->tip.pos;
+    if (predictor->tip.pos == old_pos) {
+        return NULL;
+    }
+    predictor->board.accumulated_points = predictor->tip.points;
+    return &predictor->board;
+}
+
+const Board* predictor_frame(predictor_t* predictor, const Board* frame) {
+    if (!frame->data) {
+        return frame;
+    }
+
+    int size = frame->width * frame->height;
+    int new_pos = find_pacman(frame->data, size);
+
+    if (!predictor->base || frame->width != predictor->width || frame->height != predictor->height ||
+        predictor->board.victory) {
+        // Primeiro frame de um jogo ou nível: o pacman começa com waiting 0 e PASSO por aprender
+        if ((size_t)size > predictor->capacity) {
+            char* base = realloc(predictor->base, size);
+            if (base) predictor->base = base;
+            char* cells = realloc(predictor->cells, size);
+            if (cells) predictor->cells = cells;
+            if (!base || !cells) {
+                return frame;
+            }
+            predictor->capacity = size;
+        }
+        predictor->width = frame->width;
+        predictor->height = frame->height;
+        predictor->passo = -1;
+        predictor->n_pending = 0;
+        predictor->base_model.pos = new_pos;
+        predictor->base_model.waiting = 0;
+        predictor->base_model.since_move = -1;
+    } else {
+        // Jogadas que este frame já reflete
+        unsigned int last_seq = frame->has_seq ? frame->last_seq : 0;
+        int acked = 0;
+        while (acked < predictor->n_pending && predictor->pending[acked].seq <= last_seq) {
+            if (predictor->pending[acked].predicted_pos >= 0) predictor->predicted++;
+            acked++;
+        }
+        if (acked > 0 && predictor->pending[acked - 1].predicted_pos >= 0 &&
+            predictor->pending[acked - 1].predicted_pos != new_pos) {
+            predictor->corrected++;
+        }
+
+        if (acked == 1) {
+            observe(predictor, predictor->pending[0].command, new_pos);
+        } else if (acked > 1) {
+            // Várias de uma vez: o modelo só se mantém se chegar à mesma posição
+            predict_model_t model = predictor->base_model;
+            int known = 1;
+            for (int i = 0; i < acked && known; i++) {
+                known = model_step(predictor, predictor->base, NULL, &model, predictor->pending[i].command);
+            }
+            if (!known || model.pos != new_pos) {
+                model.waiting = -1;
+                model.since_move = -1;
+            }
+            predictor->base_model.waiting = model.waiting;
+            predictor->base_model.since_move = model.since_move;
+        }
+        predictor->base_model.pos = new_pos;
+
+        predictor->n_pending -= acked;
+        memmove(predictor->pending, predictor->pending + acked, predictor->n_pending * sizeof(predict_input_t));
+    }
+
+    memcpy(predictor->base, frame->data, size);
+    predictor->base_model.points = frame->accumulated_points;
+    predictor->board = *frame;
+    predictor->board.data = predictor->cells;
+    replay_pending(predictor);
+    return &predictor->board;
+}
@@ -0,0 +1,295 @@
+#include "ansi.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Código SGR de cada par de cor (índice = par, 0 = cor por omissão)
+static const int sgr_colour[8] = {0, 33, 31, 34, 37, 32, 35, 36};
+
+static const ansi_cell_t blank_cell = {' ', 0};
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static int write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        size -= n;
+    }
+    return 0;
+}
+
+// ========== BUFFER DE SAÍDA ==========
+
+static int out_reserve(ansi_screen_t* screen, size_t extra) {
+    if (screen->out_len + extra <= screen->out_cap) {
+        return 0;
+    }
+    size_t cap = screen->out_cap ? screen->out_cap * 2 : 4096;
+    while (cap < screen->out_len + extra) cap *= 2;
+    char* out = realloc(screen->out, cap);
+    if (!out) {
+        return -1;
+    }
+    screen->out = out;
+    screen->out_cap = cap;
+    return 0;
+}
+
+static void out_append(ansi_screen_t* screen, const char* data, size_t len) {
+    if (out_reserve(screen, len) == 0) {
+        memcpy(screen->out + screen->out_len, data, len);
+        screen->out_len += len;
+    }
+}
+
+static void out_printf(ansi_screen_t* screen, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+static void out_printf(ansi_screen_t* screen, const char* format, ...) {
+    char text[64];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (len > 0) {
+        out_append(screen, text, len < (int)sizeof(text) ? (size_t)len : sizeof(text) - 1);
+    }
+}
+
+static void out_sgr(ansi_screen_t* screen, int attr) {
+    char sgr[24];
+    int len = snprintf(sgr, sizeof(sgr), "\x1b[0%s%s", (attr & ANSI_BOLD) ? ";1" : "", (attr & ANSI_DIM) ? ";2" : "");
+    if (attr & ANSI_COLOUR_MASK) {
+        len += snprintf(sgr + len, sizeof(sgr) - len, ";%d", sgr_colour[attr & ANSI_COLOUR_MASK]);
+    }
+    sgr[len++] = 'm';
+    out_append(screen, sgr, len);
+    screen->cur_attr = attr;
+}
+
+// ========== GRAVAÇÃO (ASCIICAST V2) ==========
+
+/* Acrescenta o buffer atual ao .cast como um evento de saída. */
+static void cast_frame(ansi_screen_t* screen) {
+    if (screen->cast_fd < 0) {
+        return;
+    }
+
+    char line[256];
+    if (!screen->cast_started) {
+        screen->cast_epoch_us = now_us();
+        int len = snprintf(line, sizeof(line),
+                           "{\"version\": 2, \"width\": %d, \"height\": %d, \"timestamp\": %llu, "
+                           "\"env\": {\"TERM\": \"xterm-256color\"}}\n",
+                           screen->cols > 80 ? screen->cols : 80, screen->rows > 24 ? screen->rows : 24,
+                           (unsigned long long)(screen->cast_epoch_us / 1000000ULL));
+        write_all(screen->cast_fd, line, len);
+        screen->cast_started = 1;
+    }
+
+    // Escape JSON: no pior caso cada byte vira \u00XX
+    size_t size = 64 + screen->out_len * 6;
+    char* event = malloc(size);
+    if (!event) {
+        return;
+    }
+    size_t pos = snprintf(event, size, "[%.6f, \"o\", \"", (now_us() - screen->cast_epoch_us) / 1e6);
+    for (size_t i = 0; i < screen->out_len; i++) {
+        unsigned char c = (unsigned char)screen->out[i];
+        if (c == '"' || c == '\\') {
+            event[pos++] = '\\';
+            event[pos++] = (char)c;
+        } else if (c < 0x20) {
+            pos += snprintf(event + pos, size - pos, "\\u%04x", c);
+        } else {
+            event[pos++] = (char)c;
+        }
+    }
+    pos += snprintf(event + pos, size - pos, "\"]\n");
+    write_all(screen->cast_fd, event, pos);
+    free(event);
+}
+
+// ========== GRELHA ==========
+
+/* Garante que (row, col) existe, aumentando as grelhas. */
+static int ensure_cell(ansi_screen_t* screen, int row, int col) {
+    if (row < screen->rows && col < screen->cols) {
+        return 0;
+    }
+    int rows = screen->rows > row ? screen->rows : row + 1;
+    int cols = screen->cols > col ? screen->cols : col + 1;
+    if (rows < 24) rows = 24;
+    if (cols < 80) cols = 80;
+
+    ansi_cell_t* cells = malloc((size_t)rows * cols * sizeof(ansi_cell_t));
+    ansi_cell_t* shown = malloc((size_t)rows * cols * sizeof(ansi_cell_t));
+    unsigned char* dirty = calloc(rows, 1);
+    if (!cells || !shown || !dirty) {
+        free(cells);
+        free(shown);
+        free(dirty);
+        return -1;
+    }
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int inside = r < screen->rows && c < screen->cols;
+            cells[r * cols + c] = inside ? screen->cells[r * screen->cols + c] : blank_cell;
+            shown[r * cols + c] = inside ? screen->shown[r * screen->cols + c] : blank_cell;
+        }
+        dirty[r] = r < screen->rows ? screen->dirty[r] : 0;
+    }
+
+    free(screen->cells);
+    free(screen->shown);
+    free(screen->dirty);
+    screen->cells = cells;
+    screen->shown = shown;
+    screen->dirty = dirty;
+    screen->rows = rows;
+    screen->cols = cols;
+    return 0;
+}
+
+void ansi_put(ansi_screen_t* screen, int row, int col, char ch, int attr) {
+    if (row < 0 || col < 0 || ensure_cell(screen, row, col) != 0) {
+        return;
+    }
+    if ((unsigned char)ch < 0x20 || ch == 0x7f) {
+        ch = '?';
+    }
+    ansi_cell_t* cell = &screen->cells[row * screen->cols + col];
+    if (cell->ch != ch || cell->attr != attr) {
+        cell->ch = ch;
+        cell->attr = (uint8_t)attr;
+        screen->dirty[row] = 1;
+    }
+}
+
+void ansi_print(ansi_screen_t* screen, int row, int col, int attr, const char* format, ...) {
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    for (int i = 0; text[i]; i++) {
+        ansi_put(screen, row, col + i, text[i], attr);
+    }
+}
+
+void ansi_clear_line(ansi_screen_t* screen, int row, int col) {
+    if (row < 0 || row >= screen->rows) {
+        return;
+    }
+    for (int c = col < 0 ? 0 : col; c < screen->cols; c++) {
+        ansi_put(screen, row, c, ' ', 0);
+    }
+}
+
+void ansi_clear(ansi_screen_t* screen) {
+    for (int i = 0; i < screen->rows * screen->cols; i++) {
+        screen->cells[i] = blank_cell;
+    }
+    screen->full = 1;
+}
+
+// ========== CICLO DE VIDA ==========
+
+int ansi_init(ansi_screen_t* screen, int fd, const char* cast_path) {
+    memset(screen, 0, sizeof(*screen));
+    screen->fd = fd;
+    screen->cast_fd = -1;
+    screen->full = 1;
+    screen->cur_row = -1;
+    screen->cur_col = -1;
+    screen->cur_attr = -1;
+
+    if (cast_path && *cast_path) {
+        screen->cast_fd = open(cast_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (screen->cast_fd < 0) {
+            return -1;
+        }
+    }
+    return ensure_cell(screen, 0, 0);
+}
+
+size_t ansi_refresh(ansi_screen_t* screen) {
+    screen->out_len = 0;
+
+    if (screen->full) {
+        // Terminal limpo: tudo o que não for espaço tem de ser escrito
+        static const char reset[] = "\x1b[?25l\x1b[0m\x1b[2J";
+        out_append(screen, reset, sizeof(reset) - 1);
+        screen->cur_attr = 0;
+        screen->cur_row = -1;
+        for (int i = 0; i < screen->rows * screen->cols; i++) {
+            screen->shown[i] = blank_cell;
+        }
+        memset(screen->dirty, 1, screen->rows);
+        screen->full = 0;
+    }
+
+    for (int row = 0; row < screen->rows; row++) {
+        if (!screen->dirty[row]) {
+            continue;
+        }
+        screen->dirty[row] = 0;
+        for (int col = 0; col < screen->cols; col++) {
+            ansi_cell_t* cell = &screen->cells[row * screen->cols + col];
+            ansi_cell_t* shown = &screen->shown[row * screen->cols + col];
+            if (cell->ch == shown->ch && cell->attr == shown->attr) {
+                continue;
+            }
+            if (screen->cur_row != row || screen->cur_col != col) {
+                out_printf(screen, "\x1b[%d;%dH", row + 1, col + 1);
+            }
+            if (screen->cur_attr != cell->attr) {
+                out_sgr(screen, cell->attr);
+            }
+            out_append(screen, &cell->ch, 1);
+            *shown = *cell;
+            screen->cur_row = row;
+            screen->cur_col = col + 1;
+        }
+    }
+
+    if (screen->out_len == 0) {
+        return 0;
+    }
+    if (screen->fd >= 0) {
+        write_all(screen->fd, screen->out, screen->out_len);
+    }
+    cast_frame(screen);
+    return screen->out_len;
+}
+
+void ansi_end(ansi_screen_t* screen) {
+    screen->out_len = 0;
+    out_printf(screen, "\x1b[0m\x1b[%d;1H\x1b[?25h\n", screen->rows + 1);
+    if (screen->fd >= 0) {
+        write_all(screen->fd, screen->out, screen->out_len);
+    }
+    if (screen->cast_fd >= 0) {
+        close(screen->cast_fd);
+    }
+    free(screen->cells);
+    free(screen->shown);
+    free(screen->dirty);
+    free(screen->out);
+    memset(screen, 0, sizeof(*screen));
+    screen->fd = -1;
+    screen->cast_fd = -1;
+}
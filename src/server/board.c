@@ -1,4 +1,5 @@
 #include "board.h"
+#include "log.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <time.h>
@@ -9,7 +10,6 @@
 #include <stdbool.h> 
 
 
-FILE * debugfile;
 
 static int find_and_kill_pacman(board_t* board, int new_x, int new_y) {
     for (int p = 0; p < board->n_pacmans; p++) {
@@ -332,7 +332,7 @@ int move_pacman(board_t* board, int pacman_index, command_t* command) {
 
     if (direction == 'R') {
         char directions[] = {'W', 'S', 'A', 'D'};
-        direction = directions[rand() % 4];
+        direction = directions[rng_bounded(&board->rng, 4)];
     }
 
     // Calculate new position based on direction
@@ -549,7 +549,7 @@ int move_ghost(board_t* board, int ghost_index, command_t* command) {
     
     if (direction == 'R') {
         char directions[] = {'W', 'S', 'A', 'D'};
-        direction = directions[rand() % 4];
+        direction = directions[rng_bounded(&board->rng, 4)];
     }
 
     // Calculate new position based on direction
@@ -809,21 +809,56 @@ void unload_level(board_t * board) {
     free(board->ghosts);
 }
 
+/* Ajusta um array de dst ao tamanho do de src; só realoca se a contagem mudar. */
+static int resize_array(void** array, int old_count, int new_count, size_t size) {
+    if (*array && old_count == new_count) {
+        return 0;
+    }
+    void* resized = realloc(*array, (new_count > 0 ? new_count : 1) * size);
+    if (!resized) {
+        return -1;
+    }
+    *array = resized;
+    return 0;
+}
+
+int copy_level(board_t* dst, const board_t* src) {
+    if (resize_array((void**)&dst->board, dst->width * dst->height, src->width * src->height,
+                     sizeof(board_pos_t)) != 0 ||
+        resize_array((void**)&dst->pacmans, dst->n_pacmans, src->n_pacmans, sizeof(pacman_t)) != 0 ||
+        resize_array((void**)&dst->ghosts, dst->n_ghosts, src->n_ghosts, sizeof(ghost_t)) != 0) {
+        return -1;
+    }
+
+    board_pos_t* cells = dst->board;
+    pacman_t* pacmans = dst->pacmans;
+    ghost_t* ghosts = dst->ghosts;
+    *dst = *src;
+    dst->board = cells;
+    dst->pacmans = pacmans;
+    dst->ghosts = ghosts;
+
+    memcpy(dst->board, src->board, (size_t)src->width * src->height * sizeof(board_pos_t));
+    memcpy(dst->pacmans, src->pacmans, src->n_pacmans * sizeof(pacman_t));
+    memcpy(dst->ghosts, src->ghosts, src->n_ghosts * sizeof(ghost_t));
+    return 0;
+}
+
 void open_debug_file(char *filename) {
-    debugfile = fopen(filename, "w");
+    if (log_open(filename) != 0) {
+        perror("Failed to open debug file");
+    }
 }
 
 void close_debug_file() {
-    fclose(debugfile);
+    log_close();
 }
 
 void debug(const char * format, ...) {
     va_list args;
     va_start(args, format);
-    vfprintf(debugfile, format, args);
+    log_vwrite(LOG_LEVEL_DEBUG, format, args);
     va_end(args);
-
-    fflush(debugfile);
 }
 
 void print_board(board_t *board) {
@@ -0,0 +1,190 @@
+#include "clock.h"
+#include "log.h"
+#include "board.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NSEC_PER_SEC 1000000000L
+
+static void timespec_add_ns(struct timespec* ts, long long ns) {
+    long long total = (long long)ts->tv_nsec + ns;
+    ts->tv_sec += total / NSEC_PER_SEC;
+    ts->tv_nsec = total % NSEC_PER_SEC;
+    if (ts->tv_nsec < 0) {
+        ts->tv_nsec += NSEC_PER_SEC;
+        ts->tv_sec--;
+    }
+}
+
+static long long timespec_diff_ns(const struct timespec* a, const struct timespec* b) {
+    return (long long)(a->tv_sec - b->tv_sec) * NSEC_PER_SEC + (a->tv_nsec - b->tv_nsec);
+}
+
+static int log2_bucket(unsigned long long value) {
+    int bucket = 0;
+    while (value > 0 && bucket < CLOCK_HIST_BUCKETS - 1) {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void tick_clock_init(tick_clock_t* clock, const struct timespec* epoch, int period_ms, int max_catchup) {
+    memset(clock, 0, sizeof(*clock));
+    if (epoch) {
+        clock->epoch = *epoch;
+    } else {
+        clock_gettime(CLOCK_MONOTONIC, &clock->epoch);
+    }
+    if (period_ms <= 0) {
+        period_ms = CLOCK_DEFAULT_PERIOD_MS;
+    }
+    clock->period_ns = (long)period_ms * 1000000L;
+    clock->max_catchup = max_catchup;
+}
+
+static struct timespec next_deadline(const tick_clock_t* clock) {
+    struct timespec deadline = clock->epoch;
+    timespec_add_ns(&deadline, (long long)clock->tick * clock->period_ns);
+    return deadline;
+}
+
+/* Conta o tick cujo prazo passou: atraso, ultrapassagens e ressincronização. */
+static unsigned long serve_tick(tick_clock_t* clock, const struct timespec* deadline) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long late_ns = timespec_diff_ns(&now, deadline);
+    if (late_ns < 0) late_ns = 0;
+
+    long late_us = (long)(late_ns / 1000);
+    clock->stats.jitter_hist[log2_bucket(late_us)]++;
+    if (late_us > clock->stats.max_jitter_us) {
+        clock->stats.max_jitter_us = late_us;
+    }
+
+    long long missed = late_ns / clock->period_ns;
+    if (missed > 0) {
+        clock->stats.overruns++;
+        clock->stats.overrun_hist[log2_bucket(missed)]++;
+
+        // Atraso grande: deslocar o calendário em vez de correr uma rajada de ticks
+        if (missed > clock->max_catchup) {
+            timespec_add_ns(&clock->epoch, missed * clock->period_ns);
+            clock->stats.resyncs++;
+        }
+    }
+
+    clock->stats.ticks++;
+    return clock->tick++;
+}
+
+unsigned long tick_clock_wait(tick_clock_t* clock) {
+    struct timespec deadline = next_deadline(clock);
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+        // Sinal: voltar a dormir até ao mesmo prazo
+    }
+    return serve_tick(clock, &deadline);
+}
+
+unsigned long tick_clock_wait_wake(tick_clock_t* clock, tick_wake_t* wake, unsigned long seen) {
+    struct timespec deadline = next_deadline(clock);
+
+    pthread_mutex_lock(&wake->mutex);
+    while (wake->wakeups == seen) {
+        if (pthread_cond_timedwait(&wake->cond, &wake->mutex, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    int woken = wake->wakeups != seen;
+    pthread_mutex_unlock(&wake->mutex);
+
+    return woken ? TICK_CLOCK_WOKEN : serve_tick(clock, &deadline);
+}
+
+void tick_clock_skip_to(tick_clock_t* clock, unsigned long tick) {
+    if (tick > clock->tick) {
+        clock->tick = tick;
+    }
+}
+
+// ========== DESPERTAR ANTECIPADO ==========
+
+int tick_wake_init(tick_wake_t* wake) {
+    // Os prazos são em CLOCK_MONOTONIC: a condição tem de medir o mesmo relógio
+    pthread_condattr_t attr;
+    if (pthread_condattr_init(&attr) != 0) {
+        return -1;
+    }
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    int result = pthread_cond_init(&wake->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    if (result != 0) {
+        return -1;
+    }
+    if (pthread_mutex_init(&wake->mutex, NULL) != 0) {
+        pthread_cond_destroy(&wake->cond);
+        return -1;
+    }
+    wake->wakeups = 0;
+    return 0;
+}
+
+void tick_wake_destroy(tick_wake_t* wake) {
+    pthread_mutex_destroy(&wake->mutex);
+    pthread_cond_destroy(&wake->cond);
+}
+
+unsigned long tick_wake_seen(tick_wake_t* wake) {
+    pthread_mutex_lock(&wake->mutex);
+    unsigned long seen = wake->wakeups;
+    pthread_mutex_unlock(&wake->mutex);
+    return seen;
+}
+
+void tick_wake_signal(tick_wake_t* wake) {
+    pthread_mutex_lock(&wake->mutex);
+    wake->wakeups++;
+    pthread_cond_broadcast(&wake->cond);
+    pthread_mutex_unlock(&wake->mutex);
+}
+
+void tick_wake_wait(tick_wake_t* wake, unsigned long seen) {
+    pthread_mutex_lock(&wake->mutex);
+    while (wake->wakeups == seen) {
+        pthread_cond_wait(&wake->cond, &wake->mutex);
+    }
+    pthread_mutex_unlock(&wake->mutex);
+}
+
+void tick_stats_merge(tick_stats_t* into, const tick_stats_t* from) {
+    into->ticks += from->ticks;
+    into->overruns += from->overruns;
+    into->resyncs += from->resyncs;
+    if (from->max_jitter_us > into->max_jitter_us) {
+        into->max_jitter_us = from->max_jitter_us;
+    }
+    for (int i = 0; i < CLOCK_HIST_BUCKETS; i++) {
+        into->jitter_hist[i] += from->jitter_hist[i];
+        into->overrun_hist[i] += from->overrun_hist[i];
+    }
+}
+
+static void log_histogram(const char* name, const char* unit, const unsigned long* hist) {
+    char line[512];
+    size_t offset = 0;
+    for (int i = 0; i < CLOCK_HIST_BUCKETS && offset < sizeof(line); i++) {
+        if (hist[i] == 0) continue;
+        unsigned long low = (i == 0) ? 0 : 1UL << (i - 1);
+        offset += snprintf(line + offset, sizeof(line) - offset, " [%lu%s+]=%lu", low, unit, hist[i]);
+    }
+    log_info("  %s:%s\n", name, offset ? line : " (empty)");
+}
+
+void tick_stats_log(const char* label, const tick_stats_t* stats) {
+    log_info("%s: %lu ticks, %lu overruns, %lu resyncs, max jitter %ld us\n",
+          label, stats->ticks, stats->overruns, stats->resyncs, stats->max_jitter_us);
+    log_histogram("tick-start jitter", "us", stats->jitter_hist);
+    log_histogram("overrun", " ticks", stats->overrun_hist);
+}
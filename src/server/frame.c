@@ -0,0 +1,55 @@
+#include "frame.h"
+#include "protocol.h"
+#include <string.h>
+
+int frame_size(board_t* board) {
+    return FRAME_HEADER_SIZE + board->width * board->height;
+}
+
+int frame_seq_size(board_t* board) {
+    return FRAME_SEQ_HEADER_SIZE + board->width * board->height;
+}
+
+static void encode_header(board_t* board, char op, int victory, int game_over, char* out) {
+    int points = board->pacmans[0].points;
+
+    out[0] = op;
+    memcpy(out + 1, &board->width, 4);
+    memcpy(out + 5, &board->height, 4);
+    memcpy(out + 9, &board->tempo, 4);
+    memcpy(out + 13, &victory, 4);
+    memcpy(out + 17, &game_over, 4);
+    memcpy(out + 21, &points, 4);
+}
+
+static int encode_cells(board_t* board, char* board_data) {
+    // Converter board interno para formato de protocolo
+    int n_cells = board->width * board->height;
+    for (int idx = 0; idx < n_cells; idx++) {
+        board_pos_t* pos = &board->board[idx];
+
+        char c = ' ';
+        if (pos->content == 'W') c = '#';      // Wall
+        else if (pos->content == 'P') c = 'C'; // Pacman (Client)
+        else if (pos->content == 'M') c = 'M'; // Ghost/Monster
+        else if (pos->has_portal) c = '@';     // Portal
+        else if (pos->has_dot) c = '.';        // Dot
+        else c = ' ';                          // Empty
+
+        board_data[idx] = c;
+    }
+    return n_cells;
+}
+
+int encode_board_frame(board_t* board, int victory, int game_over, char* out) {
+    encode_header(board, OP_CODE_BOARD, victory, game_over, out);
+    return FRAME_HEADER_SIZE + encode_cells(board, out + FRAME_HEADER_SIZE);
+}
+
+int encode_board_frame_seq(board_t* board, int victory, int game_over, unsigned int last_seq,
+                           unsigned int tick, char* out) {
+    encode_header(board, OP_CODE_BOARD_SEQ, victory, game_over, out);
+    memcpy(out + 25, &last_seq, 4);
+    memcpy(out + 29, &tick, 4);
+    return FRAME_SEQ_HEADER_SIZE + encode_cells(board, out + FRAME_SEQ_HEADER_SIZE);
+}
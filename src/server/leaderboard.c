@@ -0,0 +1,449 @@
+#include "leaderboard.h"
+#include "log.h"
+#include "trace.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+_Static_assert(sizeof(score_record_t) == 64, "score_record_t must stay 64 bytes");
+_Static_assert(sizeof(score_index_header_t) == 64, "score_index_header_t must stay 64 bytes");
+
+// Fila de jogos por escrever (preenchida pelas gestoras, esvaziada pela thread de escrita)
+static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static score_record_t* pending = NULL;
+static int n_pending = 0;
+static int pending_capacity = 0;
+
+static pthread_t writer_thread;
+static volatile int writer_running = 0;
+static int log_fd = -1;
+static int index_fd = -1;
+
+// Índice mapeado: escrito só pela thread de escrita, lido pela thread do ranking
+static pthread_rwlock_t index_lock = PTHREAD_RWLOCK_INITIALIZER;
+static score_index_header_t* index_header = NULL;
+static score_record_t* index_records = NULL;
+static uint64_t index_capacity = 0;   // Registos que cabem no mapeamento atual
+static char level_names[LEADERBOARD_MAX_LEVELS][32];
+static int n_level_names = 0;
+
+// 1 se a fica à frente de b no mesmo nível (mais pontos; em empate, o jogo mais antigo)
+static int ranks_before(const score_record_t* a, const score_record_t* b) {
+    if (a->points != b->points) return a->points > b->points;
+    return a->timestamp < b->timestamp;
+}
+
+// Ordem do índice: por nível e, dentro de cada nível, pelo ranking
+static int index_before(const score_record_t* a, const score_record_t* b) {
+    int level = strncmp(a->level, b->level, 32);
+    if (level != 0) return level < 0;
+    return ranks_before(a, b);
+}
+
+static int compare_records(const void* a, const void* b) {
+    const score_record_t* ra = (const score_record_t*)a;
+    const score_record_t* rb = (const score_record_t*)b;
+    if (index_before(ra, rb)) return -1;
+    if (index_before(rb, ra)) return 1;
+    return 0;
+}
+
+static void note_level(const char* level) {
+    for (int i = 0; i < n_level_names; i++) {
+        if (strncmp(level_names[i], level, 32) == 0) return;
+    }
+    if (n_level_names < LEADERBOARD_MAX_LEVELS) {
+        memcpy(level_names[n_level_names++], level, 32);
+    }
+}
+
+// ========== ÍNDICE ==========
+
+/* Garante espaço para capacity registos, remapeando o ficheiro.
+Chamar com index_lock para escrita. */
+static int index_reserve(uint64_t capacity) {
+    if (capacity <= index_capacity) {
+        return 0;
+    }
+    uint64_t new_capacity = index_capacity ? index_capacity : 1024;
+    while (new_capacity < capacity) new_capacity *= 2;
+
+    size_t new_size = sizeof(score_index_header_t) + new_capacity * sizeof(score_record_t);
+    if (ftruncate(index_fd, (off_t)new_size) != 0) {
+        return -1;
+    }
+    void* map = mmap(NULL, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, index_fd, 0);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    if (index_header) {
+        munmap(index_header, sizeof(score_index_header_t) + index_capacity * sizeof(score_record_t));
+    }
+    index_header = (score_index_header_t*)map;
+    index_records = (score_record_t*)((char*)map + sizeof(score_index_header_t));
+    index_capacity = new_capacity;
+    return 0;
+}
+
+/* Primeira posição em [from, count) cujo nível é >= level (after = 0) ou
+> level (after = 1). Chamar com index_lock. */
+static uint64_t level_bound(const char* level, uint64_t from, uint64_t count, int after) {
+    uint64_t lo = from, hi = count;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        int cmp = strncmp(index_records[mid].level, level, 32);
+        if (cmp < 0 || (after && cmp == 0)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Funde um lote (ordenado aqui) no índice numa só passagem, do fim para o
+início e sem memória auxiliar: só se movem as entradas a seguir à posição
+do primeiro registo do lote. O cabeçalho fica dirty durante a fusão. */
+static int index_merge(score_record_t* batch, int n) {
+    qsort(batch, n, sizeof(score_record_t), compare_records);
+
+    pthread_rwlock_wrlock(&index_lock);
+    uint64_t count = index_header->count;
+    if (index_reserve(count + n) != 0) {
+        pthread_rwlock_unlock(&index_lock);
+        return -1;
+    }
+
+    index_header->dirty = 1;
+    int64_t i = (int64_t)count - 1;
+    int64_t j = n - 1;
+    uint64_t k = count + n;
+    while (j >= 0) {
+        if (i >= 0 && index_before(&batch[j], &index_records[i])) {
+            index_records[--k] = index_records[i--];
+        } else {
+            index_records[--k] = batch[j--];
+        }
+    }
+    index_header->count = count + n;
+    index_header->dirty = 0;
+
+    for (int b = 0; b < n; b++) {
+        note_level(batch[b].level);
+    }
+    pthread_rwlock_unlock(&index_lock);
+    return 0;
+}
+
+/* Lê os registos do log a partir de first e funde-os no índice. */
+static int index_catch_up(uint64_t first, uint64_t total) {
+    if (first >= total) {
+        return 0;
+    }
+    size_t n = total - first;
+    score_record_t* records = malloc(n * sizeof(score_record_t));
+    if (!records) {
+        return -1;
+    }
+    ssize_t got = pread(log_fd, records, n * sizeof(score_record_t), (off_t)(first * sizeof(score_record_t)));
+    int rc = -1;
+    if (got == (ssize_t)(n * sizeof(score_record_t))) {
+        rc = index_merge(records, (int)n);
+    }
+    free(records);
+    return rc;
+}
+
+/* Valida o índice contra o log; reconstrói-o se não o cobrir de forma
+coerente e funde os registos que ainda lhe faltem. */
+static int index_recover(uint64_t log_records) {
+    struct stat st;
+    if (fstat(index_fd, &st) != 0) {
+        return -1;
+    }
+
+    uint64_t capacity = 0;
+    if ((size_t)st.st_size >= sizeof(score_index_header_t)) {
+        capacity = ((size_t)st.st_size - sizeof(score_index_header_t)) / sizeof(score_record_t);
+    }
+    if (index_reserve(capacity ? capacity : 1) != 0) {
+        return -1;
+    }
+
+    int valid = capacity > 0 &&
+                memcmp(index_header->magic, LEADERBOARD_INDEX_MAGIC, 4) == 0 &&
+                index_header->version == LEADERBOARD_INDEX_VERSION &&
+                !index_header->dirty &&
+                index_header->count <= log_records &&
+                index_header->count <= capacity;
+    if (!valid) {
+        if (log_records > 0) {
+            log_warn("Leaderboard: rebuilding index from %llu logged games\n",
+                     (unsigned long long)log_records);
+        }
+        memset(index_header, 0, sizeof(score_index_header_t));
+        memcpy(index_header->magic, LEADERBOARD_INDEX_MAGIC, 4);
+        index_header->version = LEADERBOARD_INDEX_VERSION;
+    }
+
+    // Os níveis vêm das entradas já indexadas (uma passagem no arranque)
+    for (uint64_t i = 0; i < index_header->count; i++) {
+        note_level(index_records[i].level);
+    }
+    return index_catch_up(index_header->count, log_records);
+}
+
+// ========== THREAD DE ESCRITA ==========
+
+static int write_all(int fd, const void* data, size_t size) {
+    const char* p = (const char*)data;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        size -= n;
+    }
+    return 0;
+}
+
+static void* writer_thread_func(void* arg) {
+    (void)arg;
+    trace_thread("leaderboard", -1);
+
+    score_record_t* batch = NULL;
+    int batch_capacity = 0;
+
+    pthread_mutex_lock(&queue_mutex);
+    while (1) {
+        while (n_pending == 0 && writer_running) {
+            pthread_cond_wait(&queue_cond, &queue_mutex);
+        }
+        if (n_pending == 0) {
+            break;  // Shutdown com a fila vazia
+        }
+
+        // Janela de agrupamento: um fsync por lote em vez de um por jogo
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += LEADERBOARD_BATCH_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (writer_running && n_pending < LEADERBOARD_BATCH_MAX) {
+            if (pthread_cond_timedwait(&queue_cond, &queue_mutex, &deadline) == ETIMEDOUT) break;
+        }
+
+        // Trocar os buffers: as gestoras continuam a enfileirar durante a escrita
+        score_record_t* records = pending;
+        int records_capacity = pending_capacity;
+        int n = n_pending;
+        pending = batch;
+        pending_capacity = batch_capacity;
+        n_pending = 0;
+        batch = records;
+        batch_capacity = records_capacity;
+        pthread_mutex_unlock(&queue_mutex);
+
+        uint64_t start = trace_begin();
+        if (write_all(log_fd, records, n * sizeof(score_record_t)) != 0 || fdatasync(log_fd) != 0) {
+            log_error("Leaderboard: failed to append %d games: %s\n", n, strerror(errno));
+        } else if (index_merge(records, n) != 0) {
+            log_error("Leaderboard: failed to grow the index\n");
+        } else {
+            log_debug("Leaderboard: %d games written\n", n);
+        }
+        trace_end("leaderboard_flush", start);
+
+        pthread_mutex_lock(&queue_mutex);
+    }
+    pthread_mutex_unlock(&queue_mutex);
+
+    free(batch);
+    return NULL;
+}
+
+// ========== API ==========
+
+void leaderboard_submit(int client_id, const char* level, int points, unsigned int ticks, int outcome) {
+    if (log_fd < 0) {
+        return;
+    }
+
+    score_record_t record;
+    memset(&record, 0, sizeof(record));
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    record.timestamp = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+    record.client_id = client_id;
+    record.points = points;
+    record.ticks = ticks;
+    record.outcome = (uint8_t)outcome;
+    strncpy(record.level, level, sizeof(record.level) - 1);
+
+    pthread_mutex_lock(&queue_mutex);
+    if (n_pending == pending_capacity) {
+        int new_capacity = pending_capacity ? pending_capacity * 2 : 64;
+        score_record_t* grown = realloc(pending, new_capacity * sizeof(score_record_t));
+        if (!grown) {
+            pthread_mutex_unlock(&queue_mutex);
+            log_warn("Leaderboard: queue full, game of client %d not recorded\n", client_id);
+            return;
+        }
+        pending = grown;
+        pending_capacity = new_capacity;
+    }
+    pending[n_pending++] = record;
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_mutex);
+}
+
+// Troço de um nível no índice: [next, end) ainda por consumir
+typedef struct {
+    uint64_t next;
+    uint64_t end;
+} level_run_t;
+
+/* Top de todos os níveis: junta os n melhores das cabeças de cada troço.
+Chamar com index_lock. */
+static int top_all_levels(score_record_t* out, int n) {
+    uint64_t count = index_header->count;
+    level_run_t* runs = NULL;
+    int n_runs = 0, runs_capacity = 0;
+    for (uint64_t start = 0; start < count;) {
+        if (n_runs == runs_capacity) {
+            runs_capacity = runs_capacity ? runs_capacity * 2 : LEADERBOARD_MAX_LEVELS;
+            level_run_t* grown = realloc(runs, runs_capacity * sizeof(level_run_t));
+            if (!grown) {
+                free(runs);
+                return 0;
+            }
+            runs = grown;
+        }
+        uint64_t end = level_bound(index_records[start].level, start, count, 1);
+        runs[n_runs++] = (level_run_t){start, end};
+        start = end;
+    }
+
+    int found = 0;
+    while (found < n) {
+        int best = -1;
+        for (int r = 0; r < n_runs; r++) {
+            if (runs[r].next < runs[r].end &&
+                (best < 0 || ranks_before(&index_records[runs[r].next], &index_records[runs[best].next]))) {
+                best = r;
+            }
+        }
+        if (best < 0) break;
+        out[found++] = index_records[runs[best].next++];
+    }
+    free(runs);
+    return found;
+}
+
+int leaderboard_top(const char* level, score_record_t* out, int n) {
+    int found = 0;
+    pthread_rwlock_rdlock(&index_lock);
+    if (index_header && !level) {
+        found = top_all_levels(out, n);
+    } else if (index_header) {
+        // Os registos do nível são contíguos e já estão por ordem do ranking
+        uint64_t count = index_header->count;
+        for (uint64_t i = level_bound(level, 0, count, 0);
+             i < count && found < n && strncmp(index_records[i].level, level, 32) == 0; i++) {
+            out[found++] = index_records[i];
+        }
+    }
+    pthread_rwlock_unlock(&index_lock);
+    return found;
+}
+
+int leaderboard_levels(char names[][32], int max) {
+    pthread_rwlock_rdlock(&index_lock);
+    int n = n_level_names < max ? n_level_names : max;
+    memcpy(names, level_names, n * 32);
+    pthread_rwlock_unlock(&index_lock);
+    return n;
+}
+
+// ========== CICLO DE VIDA ==========
+
+int leaderboard_open(const char* log_path, const char* index_path) {
+    log_fd = open(log_path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (log_fd < 0) {
+        return -1;
+    }
+    index_fd = open(index_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (index_fd < 0) {
+        close(log_fd);
+        log_fd = -1;
+        return -1;
+    }
+
+    // Um registo incompleto no fim (servidor terminado a meio de um write) é descartado
+    struct stat st;
+    fstat(log_fd, &st);
+    uint64_t log_records = (uint64_t)st.st_size / sizeof(score_record_t);
+    if ((uint64_t)st.st_size % sizeof(score_record_t) != 0) {
+        log_warn("Leaderboard: dropping a partial record at the end of %s\n", log_path);
+        if (ftruncate(log_fd, (off_t)(log_records * sizeof(score_record_t))) != 0) {
+            log_error("Leaderboard: failed to truncate %s\n", log_path);
+        }
+    }
+
+    if (index_recover(log_records) != 0) {
+        log_error("Leaderboard: failed to load index %s\n", index_path);
+        leaderboard_close();
+        return -1;
+    }
+
+    writer_running = 1;
+    if (pthread_create(&writer_thread, NULL, writer_thread_func, NULL) != 0) {
+        writer_running = 0;
+        leaderboard_close();
+        return -1;
+    }
+
+    log_info("Leaderboard: %llu games in %s\n", (unsigned long long)log_records, log_path);
+    return 0;
+}
+
+void leaderboard_close(void) {
+    if (writer_running) {
+        pthread_mutex_lock(&queue_mutex);
+        writer_running = 0;
+        pthread_cond_signal(&queue_cond);
+        pthread_mutex_unlock(&queue_mutex);
+        pthread_join(writer_thread, NULL);
+    }
+
+    pthread_rwlock_wrlock(&index_lock);
+    if (index_header) {
+        munmap(index_header, sizeof(score_index_header_t) + index_capacity * sizeof(score_record_t));
+        index_header = NULL;
+        index_records = NULL;
+        index_capacity = 0;
+    }
+    pthread_rwlock_unlock(&index_lock);
+
+    if (index_fd >= 0) close(index_fd);
+    if (log_fd >= 0) close(log_fd);
+    index_fd = -1;
+    log_fd = -1;
+
+    free(pending);
+    pending = NULL;
+    n_pending = 0;
+    pending_capacity = 0;
+}
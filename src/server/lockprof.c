@@ -0,0 +1,139 @@
+#include "lockprof.h"
+#include "log.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint64_t monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+void lockprof_init(lock_profile_t* profile) {
+    memset(profile, 0, sizeof(*profile));
+    // Último slot reservado aos locais que já não cabem na tabela
+    lock_site_t* overflow = &profile->sites[LOCKPROF_MAX_SITES - 1];
+    overflow->func = "(other)";
+    overflow->line = 0;
+}
+
+/* Procura (ou cria) o local func:line. Chamar com o mutex bloqueado. */
+static lock_site_t* find_site(lock_profile_t* profile, const char* func, int line) {
+    for (int i = 0; i < profile->n_sites; i++) {
+        lock_site_t* site = &profile->sites[i];
+        if (site->line == line && site->func == func) {
+            return site;
+        }
+    }
+    if (profile->n_sites == LOCKPROF_MAX_SITES - 1) {
+        return &profile->sites[LOCKPROF_MAX_SITES - 1];
+    }
+    lock_site_t* site = &profile->sites[profile->n_sites++];
+    site->func = func;
+    site->line = line;
+    return site;
+}
+
+// Marca o local como dono do mutex a partir de now
+static void take(lock_profile_t* profile, lock_site_t* site, uint64_t now) {
+    site->acquisitions++;
+    profile->locked_at = now;
+    __atomic_store_n(&profile->holder, site, __ATOMIC_RELAXED);
+}
+
+// Fecha a posse atual (ainda com o mutex)
+static void release(lock_profile_t* profile) {
+    lock_site_t* site = profile->holder;
+    if (!site) {
+        return;
+    }
+    uint64_t held = monotonic_ns() - profile->locked_at;
+    site->hold_ns += held;
+    if (held > site->max_hold_ns) site->max_hold_ns = held;
+    __atomic_store_n(&profile->holder, NULL, __ATOMIC_RELAXED);
+}
+
+void lockprof_lock(pthread_mutex_t* mutex, lock_profile_t* profile, const char* func, int line) {
+    if (pthread_mutex_trylock(mutex) == 0) {
+        take(profile, find_site(profile, func, line), monotonic_ns());
+        return;
+    }
+
+    // Ocupado: o dono visto agora fica com a culpa da espera (aproximado se o mutex mudar de mãos)
+    uint64_t start = monotonic_ns();
+    lock_site_t* blocker = __atomic_load_n(&profile->holder, __ATOMIC_RELAXED);
+    pthread_mutex_lock(mutex);
+    uint64_t now = monotonic_ns();
+    uint64_t waited = now - start;
+
+    lock_site_t* site = find_site(profile, func, line);
+    site->contended++;
+    site->wait_ns += waited;
+    if (waited > site->max_wait_ns) site->max_wait_ns = waited;
+    if (blocker) {
+        blocker->blocking_ns += waited;
+    }
+    take(profile, site, now);
+}
+
+void lockprof_unlock(pthread_mutex_t* mutex, lock_profile_t* profile) {
+    release(profile);
+    pthread_mutex_unlock(mutex);
+}
+
+int lockprof_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex, lock_profile_t* profile,
+                       const char* func, int line) {
+    release(profile);
+    int rc = pthread_cond_wait(cond, mutex);
+    // A readquisição faz parte da espera na condição: não conta como contenção
+    take(profile, find_site(profile, func, line), monotonic_ns());
+    return rc;
+}
+
+// ========== RELATÓRIO ==========
+
+static uint64_t site_cost(const lock_site_t* site) {
+    return site->wait_ns + site->blocking_ns;
+}
+
+// Mais custo primeiro; sem contenção, os que mais tempo têm o mutex
+static int compare_sites(const void* a, const void* b) {
+    const lock_site_t* sa = (const lock_site_t*)a;
+    const lock_site_t* sb = (const lock_site_t*)b;
+    if (site_cost(sa) != site_cost(sb)) return site_cost(sa) > site_cost(sb) ? -1 : 1;
+    if (sa->hold_ns != sb->hold_ns) return sa->hold_ns > sb->hold_ns ? -1 : 1;
+    return 0;
+}
+
+void lockprof_report(lock_profile_t* profile, pthread_mutex_t* mutex, const char* label) {
+    lock_site_t sites[LOCKPROF_MAX_SITES];
+
+    pthread_mutex_lock(mutex);
+    int n_sites = profile->n_sites;
+    memcpy(sites, profile->sites, n_sites * sizeof(lock_site_t));
+    const lock_site_t* overflow = &profile->sites[LOCKPROF_MAX_SITES - 1];
+    int overflowed = overflow->acquisitions > 0;
+    if (overflowed) {
+        sites[n_sites] = *overflow;
+    }
+    pthread_mutex_unlock(mutex);
+
+    unsigned long acquisitions = 0, contended = 0;
+    for (int i = 0; i < n_sites + overflowed; i++) {
+        acquisitions += sites[i].acquisitions;
+        contended += sites[i].contended;
+    }
+    log_info("%s: %lu acquisitions, %lu contended (%.1f%%), %d sites\n", label, acquisitions,
+             contended, acquisitions ? 100.0 * contended / acquisitions : 0.0, n_sites);
+
+    qsort(sites, n_sites + overflowed, sizeof(lock_site_t), compare_sites);
+    for (int i = 0; i < n_sites + overflowed && i < LOCKPROF_TOP_SITES; i++) {
+        lock_site_t* site = &sites[i];
+        log_info("  %s:%d acq=%lu contended=%lu wait=%.3fms (max %.3fms) "
+                 "hold=%.3fms (max %.3fms) blocked others=%.3fms\n",
+                 site->func, site->line, site->acquisitions, site->contended,
+                 site->wait_ns / 1e6, site->max_wait_ns / 1e6,
+                 site->hold_ns / 1e6, site->max_hold_ns / 1e6, site->blocking_ns / 1e6);
+    }
+}
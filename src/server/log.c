@@ -0,0 +1,468 @@
+#include "log.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+
+// Anel de uma thread: a própria escreve em head, a thread de escrita avança tail
+typedef struct log_ring {
+    unsigned char data[LOG_RING_BYTES];
+    uint64_t head;                     // Bytes publicados (release pelo produtor)
+    uint64_t tail;                     // Bytes consumidos (release pelo consumidor)
+    uint32_t dropped;                  // Registos descartados por falta de espaço
+    uint32_t dropped_reported;         // Já escritos num LOG_REC_DROPPED (só o consumidor)
+    int thread;
+    int dead;                          // 1 = thread terminou; libertar depois de esvaziar
+    struct log_ring* next;
+} log_ring_t;
+
+// Cabeçalho de um registo no anel (seguido dos argumentos)
+typedef struct {
+    uint16_t size;                     // Registo completo, cabeçalho incluído
+    uint8_t level;
+    uint64_t timestamp;
+    const char* format;
+} ring_record_t;
+
+static volatile int log_enabled = 0;
+static pthread_key_t ring_key;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static _Thread_local log_ring_t* local_ring = NULL;
+
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static log_ring_t* rings = NULL;
+static int next_thread = 1;
+
+// Estado da thread de escrita
+static pthread_t writer_thread;
+static volatile int writer_running = 0;
+static FILE* log_file = NULL;
+static char* log_path = NULL;
+static long log_bytes = 0;
+static long rotate_bytes = LOG_ROTATE_BYTES;
+
+// Tabela de formatos do ficheiro atual: endereço -> id (endereçamento aberto)
+static const char** format_keys = NULL;
+static uint32_t* format_ids = NULL;
+static uint32_t format_capacity = 0;
+static uint32_t n_formats = 0;
+
+// ========== CONVERSÕES PRINTF ==========
+
+int log_parse_spec(const char* p, log_spec_t* spec) {
+    const char* start = p++;
+    spec->modifier = LOG_MOD_NONE;
+
+    if (*p == '%') {
+        spec->length = 2;
+        spec->conversion = '%';
+        spec->arg = LOG_ARG_NONE;
+        return 1;
+    }
+
+    while (*p && strchr("-+ #0", *p)) p++;
+    while (*p >= '0' && *p <= '9') p++;
+    if (*p == '.') {
+        p++;
+        while (*p >= '0' && *p <= '9') p++;
+    }
+    if (*p == '*') {
+        return 0;  // Largura/precisão em argumento: não suportado
+    }
+
+    if (p[0] == 'h' && p[1] == 'h') { spec->modifier = LOG_MOD_HH; p += 2; }
+    else if (p[0] == 'l' && p[1] == 'l') { spec->modifier = LOG_MOD_LL; p += 2; }
+    else if (*p == 'h') { spec->modifier = LOG_MOD_H; p++; }
+    else if (*p == 'l') { spec->modifier = LOG_MOD_L; p++; }
+    else if (*p == 'z') { spec->modifier = LOG_MOD_Z; p++; }
+    else if (*p == 'j') { spec->modifier = LOG_MOD_J; p++; }
+    else if (*p == 't') { spec->modifier = LOG_MOD_T; p++; }
+    else if (*p == 'L') { spec->modifier = LOG_MOD_LONG_DOUBLE; p++; }
+
+    spec->conversion = *p;
+    switch (*p) {
+        case 'd': case 'i': case 'c': spec->arg = LOG_ARG_INT; break;
+        case 'u': case 'o': case 'x': case 'X': spec->arg = LOG_ARG_UINT; break;
+        case 'f': case 'F': case 'e': case 'E':
+        case 'g': case 'G': case 'a': case 'A': spec->arg = LOG_ARG_DOUBLE; break;
+        case 's': spec->arg = LOG_ARG_STRING; break;
+        case 'p': spec->arg = LOG_ARG_POINTER; break;
+        default: return 0;
+    }
+    spec->length = (int)(p - start) + 1;
+    return 1;
+}
+
+/* Lê o próximo argumento de args conforme spec e acrescenta-o a out.
+Devolve os bytes escritos, ou -1 se não couber. */
+static int encode_arg(log_spec_t* spec, va_list* args, unsigned char* out, int space) {
+    int64_t i = 0;
+    uint64_t u = 0;
+    double d = 0;
+
+    switch (spec->arg) {
+        case LOG_ARG_INT:
+            switch (spec->modifier) {
+                case LOG_MOD_L: i = va_arg(*args, long); break;
+                case LOG_MOD_LL: i = va_arg(*args, long long); break;
+                case LOG_MOD_Z: i = (int64_t)va_arg(*args, size_t); break;
+                case LOG_MOD_J: i = va_arg(*args, intmax_t); break;
+                case LOG_MOD_T: i = va_arg(*args, ptrdiff_t); break;
+                default: i = va_arg(*args, int); break;
+            }
+            if (space < 9) return -1;
+            out[0] = LOG_ARG_INT;
+            memcpy(out + 1, &i, 8);
+            return 9;
+        case LOG_ARG_UINT:
+            switch (spec->modifier) {
+                case LOG_MOD_L: u = va_arg(*args, unsigned long); break;
+                case LOG_MOD_LL: u = va_arg(*args, unsigned long long); break;
+                case LOG_MOD_Z: u = va_arg(*args, size_t); break;
+                case LOG_MOD_J: u = va_arg(*args, uintmax_t); break;
+                case LOG_MOD_T: u = (uint64_t)va_arg(*args, ptrdiff_t); break;
+                default: u = va_arg(*args, unsigned int); break;
+            }
+            if (space < 9) return -1;
+            out[0] = LOG_ARG_UINT;
+            memcpy(out + 1, &u, 8);
+            return 9;
+        case LOG_ARG_DOUBLE:
+            d = spec->modifier == LOG_MOD_LONG_DOUBLE ? (double)va_arg(*args, long double)
+                                                      : va_arg(*args, double);
+            if (space < 9) return -1;
+            out[0] = LOG_ARG_DOUBLE;
+            memcpy(out + 1, &d, 8);
+            return 9;
+        case LOG_ARG_POINTER:
+            u = (uint64_t)(uintptr_t)va_arg(*args, void*);
+            if (space < 9) return -1;
+            out[0] = LOG_ARG_POINTER;
+            memcpy(out + 1, &u, 8);
+            return 9;
+        case LOG_ARG_STRING: {
+            const char* s = va_arg(*args, const char*);
+            if (!s) s = "(null)";
+            size_t len = strnlen(s, LOG_MAX_STRING);
+            if (space < 3 + (int)len) return -1;
+            uint16_t len16 = (uint16_t)len;
+            out[0] = LOG_ARG_STRING;
+            memcpy(out + 1, &len16, 2);
+            memcpy(out + 3, s, len);
+            return 3 + (int)len;
+        }
+        default:
+            return 0;
+    }
+}
+
+// ========== PRODUTORES ==========
+
+static void retire_ring(void* arg) {
+    log_ring_t* ring = (log_ring_t*)arg;
+    __atomic_store_n(&ring->dead, 1, __ATOMIC_RELEASE);
+}
+
+static void create_key(void) {
+    pthread_key_create(&ring_key, retire_ring);
+}
+
+static log_ring_t* get_ring(void) {
+    if (local_ring) {
+        return local_ring;
+    }
+
+    log_ring_t* ring = calloc(1, sizeof(log_ring_t));
+    if (!ring) {
+        return NULL;
+    }
+    pthread_once(&key_once, create_key);
+
+    pthread_mutex_lock(&registry_mutex);
+    ring->thread = next_thread++;
+    ring->next = rings;
+    rings = ring;
+    pthread_mutex_unlock(&registry_mutex);
+
+    pthread_setspecific(ring_key, ring);
+    local_ring = ring;
+    return ring;
+}
+
+static void ring_copy_in(log_ring_t* ring, uint64_t pos, const void* src, size_t n) {
+    size_t offset = pos % LOG_RING_BYTES;
+    size_t first = LOG_RING_BYTES - offset < n ? LOG_RING_BYTES - offset : n;
+    memcpy(ring->data + offset, src, first);
+    memcpy(ring->data, (const unsigned char*)src + first, n - first);
+}
+
+static void ring_copy_out(log_ring_t* ring, uint64_t pos, void* dst, size_t n) {
+    size_t offset = pos % LOG_RING_BYTES;
+    size_t first = LOG_RING_BYTES - offset < n ? LOG_RING_BYTES - offset : n;
+    memcpy(dst, ring->data + offset, first);
+    memcpy((unsigned char*)dst + first, ring->data, n - first);
+}
+
+void log_vwrite(int level, const char* format, va_list args) {
+    if (!log_enabled) {
+        return;
+    }
+    log_ring_t* ring = get_ring();
+    if (!ring) {
+        return;
+    }
+
+    unsigned char record[LOG_MAX_RECORD];
+    ring_record_t header;
+    int size = sizeof(ring_record_t);
+
+    // Só os argumentos são copiados; a formatação fica para o logdecode
+    va_list copy;
+    va_copy(copy, args);
+    for (const char* p = format; *p; p++) {
+        if (*p != '%') continue;
+        log_spec_t spec;
+        if (!log_parse_spec(p, &spec)) break;
+        p += spec.length - 1;
+        if (spec.arg == LOG_ARG_NONE) continue;
+        int n = encode_arg(&spec, &copy, record + size, LOG_MAX_RECORD - size);
+        if (n < 0) break;
+        size += n;
+    }
+    va_end(copy);
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    header.size = (uint16_t)size;
+    header.level = (uint8_t)level;
+    header.timestamp = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+    header.format = format;
+    memcpy(record, &header, sizeof(header));
+
+    uint64_t head = ring->head;
+    uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (LOG_RING_BYTES - (head - tail) < (uint64_t)size) {
+        __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+        return;
+    }
+    ring_copy_in(ring, head, record, size);
+    __atomic_store_n(&ring->head, head + size, __ATOMIC_RELEASE);
+}
+
+void log_write(int level, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    log_vwrite(level, format, args);
+    va_end(args);
+}
+
+// ========== THREAD DE ESCRITA ==========
+
+static void emit(const void* data, size_t n) {
+    fwrite(data, 1, n, log_file);
+    log_bytes += (long)n;
+}
+
+static void write_file_header(void) {
+    uint8_t version = LOG_VERSION;
+    emit(LOG_MAGIC, 4);
+    emit(&version, 1);
+}
+
+static void reset_formats(void) {
+    free(format_keys);
+    free(format_ids);
+    format_capacity = 256;
+    format_keys = calloc(format_capacity, sizeof(const char*));
+    format_ids = calloc(format_capacity, sizeof(uint32_t));
+    n_formats = 0;
+}
+
+/* Id do formato no ficheiro atual; na primeira utilização escreve LOG_REC_FORMAT. */
+static uint32_t format_id(const char* format) {
+    if (n_formats * 2 >= format_capacity) {
+        const char** old_keys = format_keys;
+        uint32_t* old_ids = format_ids;
+        uint32_t old_capacity = format_capacity;
+        format_capacity *= 2;
+        format_keys = calloc(format_capacity, sizeof(const char*));
+        format_ids = calloc(format_capacity, sizeof(uint32_t));
+        for (uint32_t i = 0; i < old_capacity; i++) {
+            if (!old_keys[i]) continue;
+            uint32_t slot = (uint32_t)(((uintptr_t)old_keys[i] >> 3) & (format_capacity - 1));
+            while (format_keys[slot]) slot = (slot + 1) & (format_capacity - 1);
+            format_keys[slot] = old_keys[i];
+            format_ids[slot] = old_ids[i];
+        }
+        free(old_keys);
+        free(old_ids);
+    }
+
+    uint32_t slot = (uint32_t)(((uintptr_t)format >> 3) & (format_capacity - 1));
+    while (format_keys[slot]) {
+        if (format_keys[slot] == format) return format_ids[slot];
+        slot = (slot + 1) & (format_capacity - 1);
+    }
+
+    uint32_t id = n_formats++;
+    format_keys[slot] = format;
+    format_ids[slot] = id;
+
+    uint8_t tag = LOG_REC_FORMAT;
+    size_t len = strlen(format);
+    uint16_t len16 = len > 0xffff ? 0xffff : (uint16_t)len;
+    emit(&tag, 1);
+    emit(&id, 4);
+    emit(&len16, 2);
+    emit(format, len16);
+    return id;
+}
+
+/* <path> passa a <path>.1, os anteriores sobem um número e o mais antigo sai. */
+static void rotate(void) {
+    fclose(log_file);
+
+    char from[1024], to[1024];
+    for (int i = LOG_ROTATE_KEEP - 1; i >= 1; i--) {
+        snprintf(from, sizeof(from), "%s.%d", log_path, i);
+        snprintf(to, sizeof(to), "%s.%d", log_path, i + 1);
+        rename(from, to);
+    }
+    snprintf(to, sizeof(to), "%s.1", log_path);
+    rename(log_path, to);
+
+    log_file = fopen(log_path, "wb");
+    log_bytes = 0;
+    reset_formats();
+    if (log_file) {
+        write_file_header();
+    }
+}
+
+static void drain_ring(log_ring_t* ring) {
+    uint64_t tail = ring->tail;
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    while (tail < head && log_file) {
+        unsigned char record[LOG_MAX_RECORD];
+        ring_record_t header;
+        ring_copy_out(ring, tail, &header, sizeof(header));
+        ring_copy_out(ring, tail, record, header.size);
+
+        uint32_t id = format_id(header.format);
+        uint8_t tag = LOG_REC_MESSAGE;
+        uint16_t thread = (uint16_t)ring->thread;
+        uint16_t args_size = (uint16_t)(header.size - sizeof(header));
+        emit(&tag, 1);
+        emit(&id, 4);
+        emit(&header.level, 1);
+        emit(&thread, 2);
+        emit(&header.timestamp, 8);
+        emit(&args_size, 2);
+        emit(record + sizeof(header), args_size);
+
+        tail += header.size;
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+
+        if (log_bytes >= rotate_bytes) {
+            rotate();
+        }
+    }
+
+    uint32_t dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    if (dropped != ring->dropped_reported && log_file) {
+        uint8_t tag = LOG_REC_DROPPED;
+        uint16_t thread = (uint16_t)ring->thread;
+        uint32_t count = dropped - ring->dropped_reported;
+        emit(&tag, 1);
+        emit(&thread, 2);
+        emit(&count, 4);
+        ring->dropped_reported = dropped;
+    }
+}
+
+/* Esvazia todos os anéis e liberta os de threads terminadas. */
+static void drain_all(void) {
+    pthread_mutex_lock(&registry_mutex);
+    log_ring_t** p = &rings;
+    while (*p) {
+        log_ring_t* ring = *p;
+        int dead = __atomic_load_n(&ring->dead, __ATOMIC_ACQUIRE);
+        drain_ring(ring);
+        if (dead && ring->tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+            *p = ring->next;
+            free(ring);
+        } else {
+            p = &ring->next;
+        }
+    }
+    pthread_mutex_unlock(&registry_mutex);
+
+    if (log_file) {
+        fflush(log_file);
+    }
+}
+
+static void* writer_thread_func(void* arg) {
+    (void)arg;
+
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    struct timespec period = {0, LOG_FLUSH_INTERVAL_MS * 1000000L};
+    while (writer_running) {
+        drain_all();
+        nanosleep(&period, NULL);
+    }
+    drain_all();
+    return NULL;
+}
+
+// ========== CICLO DE VIDA ==========
+
+int log_open(const char* path) {
+    log_file = fopen(path, "wb");
+    if (!log_file) {
+        return -1;
+    }
+    log_path = strdup(path);
+
+    const char* env = getenv(LOG_ROTATE_ENV);
+    if (env && *env && atol(env) > 0) {
+        rotate_bytes = atol(env);
+    }
+
+    reset_formats();
+    write_file_header();
+
+    writer_running = 1;
+    if (pthread_create(&writer_thread, NULL, writer_thread_func, NULL) != 0) {
+        writer_running = 0;
+        fclose(log_file);
+        log_file = NULL;
+        return -1;
+    }
+    log_enabled = 1;
+    return 0;
+}
+
+void log_close(void) {
+    if (!writer_running) {
+        return;
+    }
+    log_enabled = 0;
+    writer_running = 0;
+    pthread_join(writer_thread, NULL);
+
+    if (log_file) {
+        fclose(log_file);
+        log_file = NULL;
+    }
+    free(log_path);
+    log_path = NULL;
+}
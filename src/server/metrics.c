@@ -0,0 +1,362 @@
+#include "metrics.h"
+#include "log.h"
+#include "debug.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Contadores de uma thread (só a própria escreve; a thread de métricas lê)
+typedef struct metrics_shard {
+    uint64_t counters[METRIC_COUNTERS];
+    int64_t gauges[METRIC_GAUGES];
+    uint64_t buckets[METRIC_HISTOGRAMS][METRICS_HIST_BUCKETS + 1];  // Último = acima do maior bucket
+    uint64_t sum_ns[METRIC_HISTOGRAMS];
+    struct metrics_shard* next;
+} metrics_shard_t;
+
+static const struct {
+    const char* name;
+    const char* help;
+} counter_info[METRIC_COUNTERS] = {
+    [METRIC_SESSIONS_STARTED] = {"pacman_sessions_started_total", "Games started"},
+    [METRIC_TICKS] = {"pacman_ticks_total", "Ghost ticks executed"},
+    [METRIC_FRAMES_SENT] = {"pacman_frames_sent_total", "Board frames written to clients"},
+    [METRIC_FRAME_BYTES] = {"pacman_frame_bytes_sent_total", "Bytes of board frames written"},
+    [METRIC_FRAMES_DROPPED] = {"pacman_frames_dropped_total", "Board frames whose write failed or was short"},
+    [METRIC_HANDSHAKE_FAILURES] = {"pacman_handshake_failures_total", "Invalid CONNECT messages or unreachable client FIFOs"},
+}, gauge_info[METRIC_GAUGES] = {
+    [METRIC_ACTIVE_SESSIONS] = {"pacman_sessions_active", "Games in progress"},
+    [METRIC_QUEUED_CONNECTIONS] = {"pacman_connections_queued", "CONNECT requests waiting for a manager"},
+}, hist_info[METRIC_HISTOGRAMS] = {
+    [METRIC_TICK_DURATION] = {"pacman_tick_duration_seconds", "Time spent running one ghost tick"},
+    [METRIC_MUTEX_WAIT] = {"pacman_board_mutex_wait_seconds", "Time waiting to lock board_mutex"},
+    [METRIC_MUTEX_HOLD] = {"pacman_board_mutex_hold_seconds", "Time board_mutex was held"},
+    [METRIC_LEVEL_SWITCH] = {"pacman_level_switch_seconds", "Time from a level's victory frame to the next level being live"},
+};
+
+static int metrics_enabled = 0;                 // Fixado em metrics_init, antes de haver outras threads
+static char* metrics_path = NULL;
+static pthread_key_t shard_key;                 // Destrutor retira o shard quando a thread termina
+static _Thread_local metrics_shard_t* local_shard = NULL;
+
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static metrics_shard_t* shards = NULL;          // Shards de threads vivas
+static metrics_shard_t retired;                 // Totais de threads já terminadas
+
+static pthread_t metrics_thread;
+static volatile int metrics_running = 0;
+static pthread_cond_t metrics_cond = PTHREAD_COND_INITIALIZER;
+
+// ========== SHARDS ==========
+
+// Só o dono escreve, por isso ler-somar-escrever relaxado chega (sem lock prefix)
+static inline void shard_add(uint64_t* slot, uint64_t n) {
+    __atomic_store_n(slot, __atomic_load_n(slot, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+static void fold_shard(metrics_shard_t* into, metrics_shard_t* from) {
+    for (int c = 0; c < METRIC_COUNTERS; c++) {
+        into->counters[c] += __atomic_load_n(&from->counters[c], __ATOMIC_RELAXED);
+    }
+    for (int g = 0; g < METRIC_GAUGES; g++) {
+        into->gauges[g] += __atomic_load_n(&from->gauges[g], __ATOMIC_RELAXED);
+    }
+    for (int h = 0; h < METRIC_HISTOGRAMS; h++) {
+        for (int b = 0; b <= METRICS_HIST_BUCKETS; b++) {
+            into->buckets[h][b] += __atomic_load_n(&from->buckets[h][b], __ATOMIC_RELAXED);
+        }
+        into->sum_ns[h] += __atomic_load_n(&from->sum_ns[h], __ATOMIC_RELAXED);
+    }
+}
+
+static void retire_shard(void* arg) {
+    metrics_shard_t* shard = (metrics_shard_t*)arg;
+
+    pthread_mutex_lock(&registry_mutex);
+    fold_shard(&retired, shard);
+    for (metrics_shard_t** p = &shards; *p; p = &(*p)->next) {
+        if (*p == shard) {
+            *p = shard->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&registry_mutex);
+    free(shard);
+}
+
+/* Shard da thread atual, criado e registado no primeiro uso. */
+static metrics_shard_t* get_shard(void) {
+    if (local_shard) {
+        return local_shard;
+    }
+
+    // Alinhado à linha de cache para não partilhar linhas entre threads
+    size_t size = (sizeof(metrics_shard_t) + 63) & ~(size_t)63;
+    metrics_shard_t* shard = aligned_alloc(64, size);
+    if (!shard) {
+        return NULL;
+    }
+    memset(shard, 0, size);
+
+    pthread_mutex_lock(&registry_mutex);
+    shard->next = shards;
+    shards = shard;
+    pthread_mutex_unlock(&registry_mutex);
+
+    pthread_setspecific(shard_key, shard);
+    local_shard = shard;
+    return shard;
+}
+
+void metrics_count(metric_counter_t counter, unsigned long n) {
+    if (!metrics_enabled) return;
+    metrics_shard_t* shard = get_shard();
+    if (shard) shard_add(&shard->counters[counter], n);
+}
+
+void metrics_gauge_add(metric_gauge_t gauge, long delta) {
+    if (!metrics_enabled) return;
+    metrics_shard_t* shard = get_shard();
+    if (shard) shard_add((uint64_t*)&shard->gauges[gauge], (uint64_t)delta);
+}
+
+void metrics_observe(metric_hist_t hist, uint64_t ns) {
+    if (!metrics_enabled) return;
+    metrics_shard_t* shard = get_shard();
+    if (!shard) return;
+
+    int bucket = ns == 0 ? 0 : 64 - __builtin_clzll(ns);
+    if (bucket > METRICS_HIST_BUCKETS) bucket = METRICS_HIST_BUCKETS;
+    shard_add(&shard->buckets[hist][bucket], 1);
+    shard_add(&shard->sum_ns[hist], ns);
+}
+
+uint64_t metrics_now(void) {
+    if (!metrics_enabled) return 0;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+uint64_t metrics_lock_acquired(uint64_t wait_start) {
+    if (!metrics_enabled) {
+        return 0;
+    }
+    uint64_t locked_at = metrics_now();
+    metrics_observe(METRIC_MUTEX_WAIT, locked_at - wait_start);
+    return locked_at;
+}
+
+void metrics_lock_released(uint64_t locked_at) {
+    if (!metrics_enabled) {
+        return;
+    }
+    metrics_observe(METRIC_MUTEX_HOLD, metrics_now() - locked_at);
+}
+
+// ========== EXPORTAÇÃO ==========
+
+/* Escreve o texto Prometheus num buffer novo (libertar com free). */
+static char* render_metrics(size_t* size) {
+    metrics_shard_t total;
+    memset(&total, 0, sizeof(total));
+
+    pthread_mutex_lock(&registry_mutex);
+    fold_shard(&total, &retired);
+    for (metrics_shard_t* shard = shards; shard; shard = shard->next) {
+        fold_shard(&total, shard);
+    }
+    pthread_mutex_unlock(&registry_mutex);
+
+    // Ticks por segundo desde o dump anterior
+    static uint64_t last_ticks = 0, last_ns = 0;
+    uint64_t now = metrics_now();
+    double ticks_per_second = 0.0;
+    if (last_ns != 0 && now > last_ns) {
+        ticks_per_second = (double)(total.counters[METRIC_TICKS] - last_ticks) * 1e9 / (double)(now - last_ns);
+    }
+    last_ticks = total.counters[METRIC_TICKS];
+    last_ns = now;
+
+    char* text = NULL;
+    FILE* out = open_memstream(&text, size);
+    if (!out) {
+        return NULL;
+    }
+
+    for (int c = 0; c < METRIC_COUNTERS; c++) {
+        fprintf(out, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n", counter_info[c].name,
+                counter_info[c].help, counter_info[c].name, counter_info[c].name,
+                (unsigned long long)total.counters[c]);
+    }
+    for (int g = 0; g < METRIC_GAUGES; g++) {
+        fprintf(out, "# HELP %s %s\n# TYPE %s gauge\n%s %lld\n", gauge_info[g].name,
+                gauge_info[g].help, gauge_info[g].name, gauge_info[g].name,
+                (long long)total.gauges[g]);
+    }
+    fprintf(out, "# HELP pacman_ticks_per_second Ghost ticks per second since the previous dump\n"
+                 "# TYPE pacman_ticks_per_second gauge\npacman_ticks_per_second %.1f\n",
+            ticks_per_second);
+
+    for (int h = 0; h < METRIC_HISTOGRAMS; h++) {
+        const char* name = hist_info[h].name;
+        fprintf(out, "# HELP %s %s\n# TYPE %s histogram\n", name, hist_info[h].help, name);
+        uint64_t cumulative = 0;
+        for (int b = 0; b < METRICS_HIST_BUCKETS; b++) {
+            cumulative += total.buckets[h][b];
+            // Bucket b contém durações abaixo de 2^b ns
+            fprintf(out, "%s_bucket{le=\"%g\"} %llu\n", name, (double)(1ULL << b) * 1e-9,
+                    (unsigned long long)cumulative);
+        }
+        cumulative += total.buckets[h][METRICS_HIST_BUCKETS];
+        fprintf(out, "%s_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long)cumulative);
+        fprintf(out, "%s_sum %.9f\n", name, (double)total.sum_ns[h] * 1e-9);
+        fprintf(out, "%s_count %llu\n", name, (unsigned long long)cumulative);
+    }
+
+    fclose(out);
+    return text;
+}
+
+static void write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return;
+        }
+        data += n;
+        size -= n;
+    }
+}
+
+/* Ficheiro regular: reescrito por inteiro via ficheiro temporário + rename. */
+static void dump_to_file(void) {
+    size_t size;
+    char* text = render_metrics(&size);
+    if (!text) return;
+
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", metrics_path);
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        write_all(fd, text, size);
+        close(fd);
+        rename(tmp_path, metrics_path);
+    }
+    free(text);
+}
+
+static void* metrics_thread_func(void* arg) {
+    int fifo_mode = *(int*)arg;
+    free(arg);
+
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    while (metrics_running) {
+        if (fifo_mode) {
+            // Bloqueia até um leitor abrir o FIFO; um dump por leitor
+            int fd = open(metrics_path, O_WRONLY);
+            if (fd < 0) {
+                if (errno == EINTR) continue;
+                log_error("Metrics: cannot open %s\n", metrics_path);
+                break;
+            }
+            if (metrics_running) {
+                size_t size;
+                char* text = render_metrics(&size);
+                if (text) {
+                    write_all(fd, text, size);
+                    free(text);
+                }
+            }
+            close(fd);
+            // Dar tempo ao leitor para ver EOF antes de reabrir
+            sleep_ms(100);
+            continue;
+        }
+
+        dump_to_file();
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += METRICS_FILE_INTERVAL_MS / 1000;
+        deadline.tv_nsec += (METRICS_FILE_INTERVAL_MS % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_mutex_lock(&registry_mutex);
+        if (metrics_running) {
+            pthread_cond_timedwait(&metrics_cond, &registry_mutex, &deadline);
+        }
+        pthread_mutex_unlock(&registry_mutex);
+    }
+    return NULL;
+}
+
+// ========== CICLO DE VIDA ==========
+
+int metrics_init(void) {
+    const char* path = getenv(METRICS_PATH_ENV);
+    if (!path || !*path) {
+        return 0;
+    }
+
+    // FIFO se não existir ou já for um FIFO; caso contrário ficheiro reescrito periodicamente
+    int fifo_mode = 1;
+    struct stat st;
+    if (stat(path, &st) == 0) {
+        fifo_mode = S_ISFIFO(st.st_mode);
+    } else if (mkfifo(path, 0666) != 0) {
+        perror("Failed to create metrics FIFO");
+        return -1;
+    }
+
+    if (pthread_key_create(&shard_key, retire_shard) != 0) {
+        return -1;
+    }
+    metrics_path = strdup(path);
+    metrics_enabled = 1;
+    metrics_running = 1;
+
+    int* mode = malloc(sizeof(int));
+    *mode = fifo_mode;
+    if (pthread_create(&metrics_thread, NULL, metrics_thread_func, mode) != 0) {
+        free(mode);
+        metrics_running = 0;
+        return -1;
+    }
+
+    log_info("Metrics: exporting to %s (%s)\n", metrics_path, fifo_mode ? "fifo" : "file");
+    return 0;
+}
+
+void metrics_shutdown(void) {
+    if (!metrics_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&registry_mutex);
+    metrics_running = 0;
+    pthread_cond_broadcast(&metrics_cond);
+    pthread_mutex_unlock(&registry_mutex);
+
+    // Desbloquear um open(O_WRONLY) à espera de leitor
+    int fd = open(metrics_path, O_RDONLY | O_NONBLOCK);
+    pthread_join(metrics_thread, NULL);
+    if (fd >= 0) close(fd);
+
+    free(metrics_path);
+    metrics_path = NULL;
+}
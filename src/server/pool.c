@@ -0,0 +1,308 @@
+#include "pool.h"
+#include "log.h"
+#include "board.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+
+// ========== AMOSTRAGEM DE CPU ==========
+
+/* Lê a linha agregada de /proc/stat e atualiza a fração de CPU livre desde a
+última amostra. Sem /proc assume folga total (não impede o crescimento). */
+static void sample_cpu(session_pool_t* pool) {
+    FILE* f = fopen("/proc/stat", "r");
+    if (!f) {
+        pool->cpu_idle_ratio = 1.0;
+        return;
+    }
+
+    unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
+    int n = fscanf(f, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+                   &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal);
+    fclose(f);
+    if (n != 8) {
+        pool->cpu_idle_ratio = 1.0;
+        return;
+    }
+
+    unsigned long long total = user + nice + system + idle + iowait + irq + softirq + steal;
+    unsigned long long idle_all = idle + iowait;
+
+    if (pool->cpu_total != 0 && total > pool->cpu_total) {
+        pool->cpu_idle_ratio = (double)(idle_all - pool->cpu_idle) / (double)(total - pool->cpu_total);
+    }
+    pool->cpu_total = total;
+    pool->cpu_idle = idle_all;
+}
+
+// ========== GESTÃO DE WORKERS ==========
+
+/* Cria uma gestora num slot livre. Chamar com pool->mutex bloqueado. */
+static int spawn_worker_locked(session_pool_t* pool) {
+    int slot = -1;
+    for (int i = 0; i < pool->max_workers; i++) {
+        if (pool->slot_state[i] == SLOT_FREE) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        return -1;
+    }
+
+    session_manager_args_t* args = malloc(sizeof(session_manager_args_t));
+    args->session_index = slot;
+    args->sessions = pool->sessions;
+    args->buffer = pool->buffer;
+    args->levels_directory = pool->levels_directory;
+    args->pool = pool;
+    args->warm = pool->warm;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    pthread_t thread;
+    int rc = pthread_create(&thread, &attr, pool->worker_func, args);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        free(args);
+        return -1;
+    }
+
+    pool->slot_state[slot] = SLOT_IDLE;
+    pool->n_workers++;
+    log_debug("Pool: worker %d started (%d/%d workers)\n", slot, pool->n_workers, pool->max_workers);
+    return 0;
+}
+
+/* Cresce se há pedidos em fila sem gestora livre. Acima de min_workers só
+cresce com folga de CPU. Chamar com pool->mutex bloqueado. */
+static void grow_if_needed_locked(session_pool_t* pool) {
+    int queued;
+    connection_buffer_stats(pool->buffer, &queued, NULL);
+    int idle = pool->n_workers - pool->n_busy;
+
+    while (queued > idle && pool->n_workers < pool->max_workers) {
+        if (pool->n_workers >= pool->min_workers && pool->cpu_idle_ratio < POOL_MIN_CPU_IDLE) {
+            break;
+        }
+        if (spawn_worker_locked(pool) != 0) {
+            break;
+        }
+        idle++;
+    }
+}
+
+// ========== THREAD DE ESCALONAMENTO ==========
+
+static void* scaler_thread_func(void* arg) {
+    session_pool_t* pool = (session_pool_t*)arg;
+
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    while (pool->running) {
+        sleep_ms(POOL_SCALER_INTERVAL_MS);
+
+        pthread_mutex_lock(&pool->mutex);
+        sample_cpu(pool);
+
+        // Repor o mínimo (p.ex. se um pthread_create falhou)
+        while (pool->running && pool->n_workers < pool->min_workers) {
+            if (spawn_worker_locked(pool) != 0) break;
+        }
+        grow_if_needed_locked(pool);
+        pthread_mutex_unlock(&pool->mutex);
+
+        // Encolher o anel para metade quando está quase vazio
+        int capacity;
+        int new_capacity = shrink_connection_buffer(pool->buffer, pool->min_workers, &capacity);
+        if (new_capacity != capacity) {
+            log_debug("Pool: ring shrunk %d -> %d\n", capacity, new_capacity);
+        }
+    }
+
+    return NULL;
+}
+
+// ========== API ==========
+
+int pool_init(session_pool_t* pool, int min_workers, int max_workers,
+              connection_buffer_t* buffer, char* levels_directory,
+              void* (*worker_func)(void*), void* warm) {
+    memset(pool, 0, sizeof(*pool));
+    pool->sessions = calloc(max_workers, sizeof(session_t*));
+    pool->slot_state = calloc(max_workers, sizeof(slot_state_t));
+    if (!pool->sessions || !pool->slot_state) {
+        free(pool->sessions);
+        free(pool->slot_state);
+        return -1;
+    }
+
+    pool->min_workers = min_workers;
+    pool->max_workers = max_workers;
+    pool->buffer = buffer;
+    pool->levels_directory = levels_directory;
+    pool->worker_func = worker_func;
+    pool->warm = warm;
+    pool->cpu_idle_ratio = 1.0;
+    pool->running = 1;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->workers_cond, NULL);
+
+    pthread_mutex_lock(&pool->mutex);
+    sample_cpu(pool);
+    for (int i = 0; i < min_workers; i++) {
+        spawn_worker_locked(pool);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    pthread_create(&pool->scaler_thread, NULL, scaler_thread_func, pool);
+    return 0;
+}
+
+void pool_destroy(session_pool_t* pool) {
+    pool->running = 0;
+    pthread_join(pool->scaler_thread, NULL);
+
+    // Acordar gestoras ociosas; as ocupadas saem quando a sessão terminar
+    pthread_mutex_lock(&pool->mutex);
+    for (int i = 0; i < pool->n_workers; i++) {
+        sem_post(&pool->buffer->full);
+    }
+    while (pool->n_workers > 0) {
+        pthread_cond_wait(&pool->workers_cond, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->workers_cond);
+    free(pool->sessions);
+    free(pool->slot_state);
+}
+
+void pool_submit(session_pool_t* pool, connection_request_t* request) {
+    connection_buffer_t* buffer = pool->buffer;
+
+    // Anel cheio: duplicar a capacidade (até max_workers) antes de bloquear
+    if (sem_trywait(&buffer->empty) != 0) {
+        int capacity;
+        int new_capacity = grow_connection_buffer(buffer, pool->max_workers, &capacity);
+        if (new_capacity != capacity) {
+            log_debug("Pool: ring grown %d -> %d\n", capacity, new_capacity);
+        }
+        sem_wait(&buffer->empty);  // Bloqueia se buffer cheio
+    }
+
+    prof_lock(&buffer->mutex, &buffer->profile);
+    buffer->requests[buffer->head] = *request;
+    buffer->head = (buffer->head + 1) % buffer->max_size;
+    buffer->count++;
+    int count = buffer->count;
+    int capacity = buffer->max_size;  // Muda quando o anel cresce: lido com o lock
+    prof_unlock(&buffer->mutex, &buffer->profile);
+    sem_post(&buffer->full);
+    metrics_gauge_add(METRIC_QUEUED_CONNECTIONS, 1);
+    log_debug("Pool: Request queued (buffer count=%d, capacity=%d)\n", count, capacity);
+
+    pthread_mutex_lock(&pool->mutex);
+    grow_if_needed_locked(pool);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void pool_set_session(session_pool_t* pool, int slot, session_t* session) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->sessions[slot] = session;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+int pool_next_request(session_pool_t* pool, int slot, connection_request_t* request) {
+    connection_buffer_t* buffer = pool->buffer;
+
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->slot_state[slot] == SLOT_BUSY) {
+        pool->n_busy--;
+    }
+    pool->slot_state[slot] = SLOT_IDLE;
+    pthread_mutex_unlock(&pool->mutex);
+
+    struct timespec idle_since;
+    clock_gettime(CLOCK_MONOTONIC, &idle_since);
+
+    while (1) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += POOL_SCALER_INTERVAL_MS / 1000;
+        deadline.tv_nsec += (POOL_SCALER_INTERVAL_MS % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        int rc = sem_timedwait(&buffer->full, &deadline);
+
+        if (!pool->running) {
+            if (rc == 0) {
+                sem_post(&buffer->full);  // Não consumir pedidos durante o shutdown
+            }
+            break;
+        }
+
+        if (rc == 0) {
+            prof_lock(&buffer->mutex, &buffer->profile);
+            *request = buffer->requests[buffer->tail];
+            buffer->tail = (buffer->tail + 1) % buffer->max_size;
+            buffer->count--;
+            prof_unlock(&buffer->mutex, &buffer->profile);
+            sem_post(&buffer->empty);
+            metrics_gauge_add(METRIC_QUEUED_CONNECTIONS, -1);
+
+            pthread_mutex_lock(&pool->mutex);
+            pool->slot_state[slot] = SLOT_BUSY;
+            pool->n_busy++;
+            pthread_mutex_unlock(&pool->mutex);
+            return 0;
+        }
+
+        if (errno != ETIMEDOUT && errno != EINTR) {
+            continue;
+        }
+
+        // Gestoras acima do mínimo terminam após POOL_IDLE_TIMEOUT_MS ociosas
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long idle_ms = (now.tv_sec - idle_since.tv_sec) * 1000L +
+                       (now.tv_nsec - idle_since.tv_nsec) / 1000000L;
+        if (idle_ms < POOL_IDLE_TIMEOUT_MS) {
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->mutex);
+        if (pool->n_workers > pool->min_workers) {
+            pool->slot_state[slot] = SLOT_FREE;
+            pool->n_workers--;
+            log_debug("Pool: worker %d retired after %ld ms idle (%d/%d workers)\n",
+                  slot, idle_ms, pool->n_workers, pool->max_workers);
+            pthread_cond_broadcast(&pool->workers_cond);
+            pthread_mutex_unlock(&pool->mutex);
+            return -1;
+        }
+        pthread_mutex_unlock(&pool->mutex);
+        idle_since = now;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->slot_state[slot] = SLOT_FREE;
+    pool->n_workers--;
+    pthread_cond_broadcast(&pool->workers_cond);
+    pthread_mutex_unlock(&pool->mutex);
+    return -1;
+}
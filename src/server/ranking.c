@@ -0,0 +1,285 @@
+#define _DEFAULT_SOURCE
+#include "ranking.h"
+#include "log.h"
+#include "trace.h"
+#include "leaderboard.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
+
+typedef struct {
+    int client_id;
+    int points;
+    int top_pos;                       // Posição em top[], -1 = fora do top
+    unsigned long order;               // Ordem de entrada (desempate: mais antigo primeiro)
+    int next_free;                     // Próxima entrada livre (entradas fora de uso)
+} ranking_entry_t;
+
+static pthread_mutex_t ranking_mutex = PTHREAD_MUTEX_INITIALIZER;
+static ranking_entry_t* entries = NULL;
+static int n_entries = 0;              // Entradas já usadas alguma vez (ativas ou livres)
+static int capacity = 0;
+static int free_list = -1;
+static int n_active = 0;
+static unsigned long next_order = 0;
+
+// Melhores entradas ativas, por ordem decrescente
+static int top[RANKING_TOP];
+static int n_top = 0;
+
+static int signal_fd = -1;
+static pthread_t ranking_thread;
+static volatile int ranking_running = 0;
+
+// ========== TOP-K ==========
+
+// 1 se a entrada a fica à frente de b
+static int ranks_before(const ranking_entry_t* a, const ranking_entry_t* b) {
+    if (a->points != b->points) return a->points > b->points;
+    return a->order < b->order;
+}
+
+static void top_remove(int handle) {
+    int pos = entries[handle].top_pos;
+    for (int i = pos; i < n_top - 1; i++) {
+        top[i] = top[i + 1];
+        entries[top[i]].top_pos = i;
+    }
+    n_top--;
+    entries[handle].top_pos = -1;
+}
+
+// Insere ordenado (chamar com espaço em top[])
+static void top_insert(int handle) {
+    ranking_entry_t* entry = &entries[handle];
+    int pos = n_top;
+    while (pos > 0 && ranks_before(entry, &entries[top[pos - 1]])) {
+        top[pos] = top[pos - 1];
+        entries[top[pos]].top_pos = pos;
+        pos--;
+    }
+    top[pos] = handle;
+    entry->top_pos = pos;
+    n_top++;
+}
+
+/* Completa o top com as melhores entradas de fora. Percorre todas as
+entradas, mas só corre quando um membro do top sai ou desce. */
+static void top_refill(void) {
+    while (n_top < RANKING_TOP && n_top < n_active) {
+        int best = -1;
+        for (int i = 0; i < n_entries; i++) {
+            ranking_entry_t* entry = &entries[i];
+            if (entry->client_id < 0 || entry->top_pos >= 0) continue;
+            if (best < 0 || ranks_before(entry, &entries[best])) best = i;
+        }
+        if (best < 0) break;
+        top_insert(best);
+    }
+}
+
+// Coloca uma entrada de fora no top se bater a última
+static void top_offer(int handle) {
+    if (n_top < RANKING_TOP) {
+        top_insert(handle);
+    } else if (ranks_before(&entries[handle], &entries[top[n_top - 1]])) {
+        top_remove(top[n_top - 1]);
+        top_insert(handle);
+    }
+}
+
+// ========== ENTRADAS ==========
+
+int ranking_join(int client_id, int points) {
+    pthread_mutex_lock(&ranking_mutex);
+    int handle;
+    if (free_list >= 0) {
+        handle = free_list;
+        free_list = entries[handle].next_free;
+    } else {
+        if (n_entries == capacity) {
+            int new_capacity = capacity ? capacity * 2 : 64;
+            ranking_entry_t* grown = realloc(entries, new_capacity * sizeof(ranking_entry_t));
+            if (!grown) {
+                pthread_mutex_unlock(&ranking_mutex);
+                return -1;
+            }
+            entries = grown;
+            capacity = new_capacity;
+        }
+        handle = n_entries++;
+    }
+
+    ranking_entry_t* entry = &entries[handle];
+    entry->client_id = client_id < 0 ? 0 : client_id;
+    entry->points = points;
+    entry->top_pos = -1;
+    entry->order = next_order++;
+    n_active++;
+    top_offer(handle);
+    pthread_mutex_unlock(&ranking_mutex);
+    return handle;
+}
+
+void ranking_update(int handle, int points) {
+    if (handle < 0) return;
+
+    pthread_mutex_lock(&ranking_mutex);
+    ranking_entry_t* entry = &entries[handle];
+    int old_points = entry->points;
+    entry->points = points;
+
+    if (entry->top_pos < 0) {
+        top_offer(handle);
+    } else if (points >= old_points) {
+        top_remove(handle);
+        top_insert(handle);
+    } else {
+        // Desceu: alguém de fora pode agora passar à frente
+        top_remove(handle);
+        top_refill();
+    }
+    pthread_mutex_unlock(&ranking_mutex);
+}
+
+void ranking_leave(int handle) {
+    if (handle < 0) return;
+
+    pthread_mutex_lock(&ranking_mutex);
+    ranking_entry_t* entry = &entries[handle];
+    int was_top = entry->top_pos >= 0;
+    if (was_top) {
+        top_remove(handle);
+    }
+    entry->client_id = -1;
+    entry->next_free = free_list;
+    free_list = handle;
+    n_active--;
+    if (was_top) {
+        top_refill();
+    }
+    pthread_mutex_unlock(&ranking_mutex);
+}
+
+// ========== ESCRITA ==========
+
+static void write_scores(FILE* log_file, const score_record_t* scores, int n) {
+    for (int i = 0; i < n; i++) {
+        fprintf(log_file, "%d. Client %d: %d points (%s)\n", i + 1, scores[i].client_id,
+                scores[i].points, scores[i].level);
+    }
+}
+
+// Jogos terminados, lidos do índice do leaderboard (sem percorrer o log)
+static void write_all_time(FILE* log_file) {
+    score_record_t scores[RANKING_TOP];
+    int n = leaderboard_top(NULL, scores, RANKING_TOP);
+    fprintf(log_file, "\n=== All-time Top %d ===\n", RANKING_TOP);
+    write_scores(log_file, scores, n);
+
+    char levels[LEADERBOARD_MAX_LEVELS][32];
+    int n_levels = leaderboard_levels(levels, LEADERBOARD_MAX_LEVELS);
+    for (int l = 0; l < n_levels; l++) {
+        n = leaderboard_top(levels[l], scores, RANKING_TOP);
+        fprintf(log_file, "\n=== All-time Top %d on %.32s ===\n", RANKING_TOP, levels[l]);
+        write_scores(log_file, scores, n);
+    }
+}
+
+int ranking_write(void) {
+    int client_ids[RANKING_TOP];
+    int points[RANKING_TOP];
+
+    // Cópia coerente do top; o disco fica fora do lock
+    pthread_mutex_lock(&ranking_mutex);
+    int count = n_top;
+    int active = n_active;
+    for (int i = 0; i < count; i++) {
+        client_ids[i] = entries[top[i]].client_id;
+        points[i] = entries[top[i]].points;
+    }
+    pthread_mutex_unlock(&ranking_mutex);
+
+    const char* tmp_path = RANKING_PATH ".tmp";
+    FILE* log_file = fopen(tmp_path, "w");
+    if (!log_file) {
+        perror("Failed to create ranking.log");
+        return -1;
+    }
+
+    fprintf(log_file, "=== Top %d Clients ===\n", RANKING_TOP);
+    for (int i = 0; i < count; i++) {
+        fprintf(log_file, "%d. Client %d: %d points\n", i + 1, client_ids[i], points[i]);
+    }
+    write_all_time(log_file);
+
+    if (fclose(log_file) != 0 || rename(tmp_path, RANKING_PATH) != 0) {
+        perror("Failed to write ranking.log");
+        return -1;
+    }
+
+    log_info("Generated ranking.log with %d clients\n", active);
+    return 0;
+}
+
+// ========== THREAD DE SINAIS ==========
+
+static void* ranking_thread_func(void* arg) {
+    (void)arg;
+    trace_thread("ranking", -1);
+
+    while (ranking_running) {
+        struct signalfd_siginfo info;
+        ssize_t n = read(signal_fd, &info, sizeof(info));
+        if (n != (ssize_t)sizeof(info)) {
+            if (n < 0 && errno == EINTR) continue;
+            perror("Ranking: signalfd read failed");
+            break;
+        }
+        if (!ranking_running) {
+            break;
+        }
+        log_debug("Ranking: SIGUSR1 received\n");
+        ranking_write();
+    }
+    return NULL;
+}
+
+int ranking_init(void) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+
+    // Já bloqueado pelo main em todas as threads; o signalfd só o recebe assim
+    if (pthread_sigmask(SIG_BLOCK, &set, NULL) != 0) {
+        return -1;
+    }
+    signal_fd = signalfd(-1, &set, SFD_CLOEXEC);
+    if (signal_fd < 0) {
+        return -1;
+    }
+
+    ranking_running = 1;
+    if (pthread_create(&ranking_thread, NULL, ranking_thread_func, NULL) != 0) {
+        ranking_running = 0;
+        close(signal_fd);
+        signal_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+void ranking_shutdown(void) {
+    if (!ranking_running) {
+        return;
+    }
+    ranking_running = 0;
+    pthread_kill(ranking_thread, SIGUSR1);  // Acorda o read() do signalfd
+    pthread_join(ranking_thread, NULL);
+    close(signal_fd);
+    signal_fd = -1;
+}
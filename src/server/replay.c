@@ -0,0 +1,651 @@
+#include "replay.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FOOTER_SIZE 12
+
+// ========== CODIFICAÇÃO ==========
+
+static void put_varint(FILE* file, unsigned long value) {
+    while (value >= 0x80) {
+        fputc((int)(value & 0x7f) | 0x80, file);
+        value >>= 7;
+    }
+    fputc((int)value, file);
+}
+
+// Inteiros com sinal em zigzag (-1 -> 1, 1 -> 2)
+static void put_int(FILE* file, int value) {
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (value < 0 ? 0xffffffffu : 0u);
+    put_varint(file, zigzag);
+}
+
+static void put_le(FILE* file, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        fputc((int)((value >> (8 * i)) & 0xff), file);
+    }
+}
+
+static int get_varint(const unsigned char* data, size_t* pos, size_t end, unsigned long* value) {
+    unsigned long result = 0;
+    int shift = 0;
+    while (*pos < end && shift < 64) {
+        unsigned char byte = data[(*pos)++];
+        result |= (unsigned long)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 0;
+        }
+        shift += 7;
+    }
+    return -1;
+}
+
+static int get_int(const unsigned char* data, size_t* pos, size_t end, int* value) {
+    unsigned long raw;
+    if (get_varint(data, pos, end, &raw) != 0) return -1;
+    uint32_t zigzag = (uint32_t)raw;
+    *value = (int)((zigzag >> 1) ^ (0u - (zigzag & 1u)));
+    return 0;
+}
+
+static uint64_t get_le(const unsigned char* data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t)data[i] << (8 * i);
+    }
+    return value;
+}
+
+// ========== KEYFRAMES ==========
+
+/* Estado de um keyframe:
+   rng.state u64 | rng.inc u64
+   células em RLE: (varint repetições, u8 conteúdo | has_dot << 7) até cobrir width * height
+   por pacman: pos_x, pos_y, alive, points, waiting, current_move, turns_left de cada movimento
+   por ghost:  pos_x, pos_y, waiting, current_move, charged, turns_left de cada movimento,
+               varint (due - tick + 1), 0 = fora do escalonador
+   Paredes, portais, PASSO e scripts vêm do ficheiro do nível e não são guardados. */
+
+static unsigned char cell_byte(board_pos_t* cell) {
+    return (unsigned char)((cell->content & 0x7f) | (cell->has_dot ? 0x80 : 0));
+}
+
+static void encode_keyframe(FILE* out, unsigned long tick, board_t* board, entity_sched_t* sched) {
+    put_le(out, board->rng.state, 8);
+    put_le(out, board->rng.inc, 8);
+
+    int n_cells = board->width * board->height;
+    int i = 0;
+    while (i < n_cells) {
+        unsigned char value = cell_byte(&board->board[i]);
+        int run = 1;
+        while (i + run < n_cells && cell_byte(&board->board[i + run]) == value) {
+            run++;
+        }
+        put_varint(out, run);
+        fputc(value, out);
+        i += run;
+    }
+
+    for (int p = 0; p < board->n_pacmans; p++) {
+        pacman_t* pac = &board->pacmans[p];
+        put_int(out, pac->pos_x);
+        put_int(out, pac->pos_y);
+        put_int(out, pac->alive);
+        put_int(out, pac->points);
+        put_int(out, pac->waiting);
+        put_int(out, pac->current_move);
+        for (int m = 0; m < pac->n_moves; m++) {
+            put_int(out, pac->moves[m].turns_left);
+        }
+    }
+
+    for (int g = 0; g < board->n_ghosts; g++) {
+        ghost_t* ghost = &board->ghosts[g];
+        put_int(out, ghost->pos_x);
+        put_int(out, ghost->pos_y);
+        put_int(out, ghost->waiting);
+        put_int(out, ghost->current_move);
+        put_int(out, ghost->charged);
+        for (int m = 0; m < ghost->n_moves; m++) {
+            put_int(out, ghost->moves[m].turns_left);
+        }
+        unsigned long due = sched_due(sched, g);
+        put_varint(out, due == SCHED_IDLE ? 0 : due - tick + 1);
+    }
+}
+
+static int decode_keyframe(const unsigned char* data, size_t pos, size_t end, unsigned long tick,
+                           board_t* board, entity_sched_t* sched) {
+    if (end - pos < 16) return -1;
+    board->rng.state = get_le(data + pos, 8);
+    board->rng.inc = get_le(data + pos + 8, 8);
+    pos += 16;
+
+    int n_cells = board->width * board->height;
+    int i = 0;
+    while (i < n_cells) {
+        unsigned long run;
+        if (get_varint(data, &pos, end, &run) != 0 || pos >= end) return -1;
+        if (run == 0 || run > (unsigned long)(n_cells - i)) return -1;
+        unsigned char value = data[pos++];
+        for (unsigned long r = 0; r < run; r++, i++) {
+            board->board[i].content = (char)(value & 0x7f);
+            board->board[i].has_dot = (value & 0x80) ? 1 : 0;
+        }
+    }
+
+    for (int p = 0; p < board->n_pacmans; p++) {
+        pacman_t* pac = &board->pacmans[p];
+        if (get_int(data, &pos, end, &pac->pos_x) != 0 ||
+            get_int(data, &pos, end, &pac->pos_y) != 0 ||
+            get_int(data, &pos, end, &pac->alive) != 0 ||
+            get_int(data, &pos, end, &pac->points) != 0 ||
+            get_int(data, &pos, end, &pac->waiting) != 0 ||
+            get_int(data, &pos, end, &pac->current_move) != 0) {
+            return -1;
+        }
+        for (int m = 0; m < pac->n_moves; m++) {
+            if (get_int(data, &pos, end, &pac->moves[m].turns_left) != 0) return -1;
+        }
+    }
+
+    unsigned long due[MAX_GHOSTS];
+    for (int g = 0; g < board->n_ghosts && g < MAX_GHOSTS; g++) {
+        ghost_t* ghost = &board->ghosts[g];
+        if (get_int(data, &pos, end, &ghost->pos_x) != 0 ||
+            get_int(data, &pos, end, &ghost->pos_y) != 0 ||
+            get_int(data, &pos, end, &ghost->waiting) != 0 ||
+            get_int(data, &pos, end, &ghost->current_move) != 0 ||
+            get_int(data, &pos, end, &ghost->charged) != 0) {
+            return -1;
+        }
+        for (int m = 0; m < ghost->n_moves; m++) {
+            if (get_int(data, &pos, end, &ghost->moves[m].turns_left) != 0) return -1;
+        }
+        unsigned long offset;
+        if (get_varint(data, &pos, end, &offset) != 0) return -1;
+        due[g] = offset == 0 ? SCHED_IDLE : tick + offset - 1;
+    }
+    sched_restore(sched, board, due);
+    return 0;
+}
+
+// ========== GRAVADOR ==========
+
+recorder_t* recorder_open(const char* dir, int client_id, board_t* board, int level_index) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/client%d-%lld%09ld.pmr",
+             dir, client_id, (long long)now.tv_sec, now.tv_nsec);
+
+    recorder_t* recorder = calloc(1, sizeof(recorder_t));
+    if (!recorder) {
+        return NULL;
+    }
+    recorder->file = fopen(path, "wb");
+    if (!recorder->file) {
+        free(recorder);
+        return NULL;
+    }
+
+    const char* interval = getenv(REPLAY_KEYFRAME_ENV);
+    recorder->keyframe_interval = (interval && *interval) ? strtoul(interval, NULL, 10)
+                                                         : REPLAY_KEYFRAME_INTERVAL;
+    recorder->next_keyframe = recorder->keyframe_interval;
+
+    size_t name_len = strlen(board->level_name);
+    if (name_len > 255) name_len = 255;
+
+    fwrite(REPLAY_MAGIC, 1, 4, recorder->file);
+    fputc(REPLAY_VERSION, recorder->file);
+    put_le(recorder->file, board->seed, 8);
+    put_le(recorder->file, (uint64_t)(uint32_t)board->tempo, 4);
+    fputc((int)name_len, recorder->file);
+    fwrite(board->level_name, 1, name_len, recorder->file);
+    // Níveis depois do primeiro começam com os pontos acumulados
+    int points = board->pacmans[0].points;
+    put_le(recorder->file, (uint64_t)(uint32_t)(points < 0 ? 0 : points), 4);
+    put_le(recorder->file, (uint64_t)(uint16_t)level_index, 2);
+    return recorder;
+}
+
+void recorder_input(recorder_t* recorder, unsigned long tick, char command) {
+    fputc(REC_INPUT, recorder->file);
+    put_varint(recorder->file, tick - recorder->last_tick);
+    fputc((unsigned char)command, recorder->file);
+    recorder->last_tick = tick;
+    recorder->n_inputs++;
+}
+
+void recorder_tick(recorder_t* recorder, unsigned long tick, board_t* board, entity_sched_t* sched) {
+    if (recorder->keyframe_interval == 0 || tick < recorder->next_keyframe) {
+        return;
+    }
+    recorder->next_keyframe = tick + recorder->keyframe_interval;
+
+    if (recorder->n_keyframes == recorder->keyframes_capacity) {
+        int capacity = recorder->keyframes_capacity ? recorder->keyframes_capacity * 2 : 16;
+        replay_keyframe_t* grown = realloc(recorder->keyframes, capacity * sizeof(replay_keyframe_t));
+        if (!grown) return;
+        recorder->keyframes = grown;
+        recorder->keyframes_capacity = capacity;
+    }
+
+    // O tamanho do estado vem antes dele, por isso codifica-se primeiro em memória
+    char* body = NULL;
+    size_t body_size = 0;
+    FILE* out = open_memstream(&body, &body_size);
+    if (!out) return;
+    encode_keyframe(out, tick, board, sched);
+    fclose(out);
+
+    long offset = ftell(recorder->file);
+    if (offset >= 0) {
+        recorder->keyframes[recorder->n_keyframes].tick = tick;
+        recorder->keyframes[recorder->n_keyframes].offset = (size_t)offset;
+        recorder->n_keyframes++;
+    }
+
+    fputc(REC_KEYFRAME, recorder->file);
+    put_varint(recorder->file, tick - recorder->last_tick);
+    put_varint(recorder->file, body_size);
+    fwrite(body, 1, body_size, recorder->file);
+    recorder->last_tick = tick;
+    free(body);
+}
+
+void recorder_end(recorder_t* recorder, unsigned long tick, int outcome, int points) {
+    fputc(REC_END, recorder->file);
+    put_varint(recorder->file, tick - recorder->last_tick);
+    fputc(outcome, recorder->file);
+    put_varint(recorder->file, (unsigned long)(points < 0 ? 0 : points));
+    recorder->last_tick = tick;
+}
+
+void recorder_close(recorder_t* recorder) {
+    long index_offset = ftell(recorder->file);
+    if (index_offset >= 0) {
+        fputc(REC_INDEX, recorder->file);
+        put_varint(recorder->file, recorder->n_keyframes);
+        unsigned long last_tick = 0;
+        size_t last_offset = 0;
+        for (int i = 0; i < recorder->n_keyframes; i++) {
+            put_varint(recorder->file, recorder->keyframes[i].tick - last_tick);
+            put_varint(recorder->file, recorder->keyframes[i].offset - last_offset);
+            last_tick = recorder->keyframes[i].tick;
+            last_offset = recorder->keyframes[i].offset;
+        }
+        put_le(recorder->file, (uint64_t)index_offset, 8);
+        fwrite(REPLAY_INDEX_MAGIC, 1, 4, recorder->file);
+    }
+
+    fclose(recorder->file);
+    free(recorder->keyframes);
+    free(recorder);
+}
+
+// ========== LEITOR ==========
+
+/* Lê o índice do rodapé. Devolve -1 se não existir ou estiver inválido. */
+static int load_index(replay_t* replay) {
+    if (replay->size < replay->records + FOOTER_SIZE ||
+        memcmp(replay->data + replay->size - 4, REPLAY_INDEX_MAGIC, 4) != 0) {
+        return -1;
+    }
+    uint64_t index_offset = get_le(replay->data + replay->size - FOOTER_SIZE, 8);
+    size_t end = replay->size - FOOTER_SIZE;
+    if (index_offset < replay->records || index_offset >= end ||
+        replay->data[index_offset] != REC_INDEX) {
+        return -1;
+    }
+
+    size_t pos = index_offset + 1;
+    unsigned long count;
+    if (get_varint(replay->data, &pos, end, &count) != 0 || count > end - pos) {
+        return -1;
+    }
+    replay->keyframes = malloc((count ? count : 1) * sizeof(replay_keyframe_t));
+    if (!replay->keyframes) {
+        return -1;
+    }
+
+    unsigned long tick = 0, offset = 0;
+    for (unsigned long i = 0; i < count; i++) {
+        unsigned long tick_delta, offset_delta;
+        if (get_varint(replay->data, &pos, end, &tick_delta) != 0 ||
+            get_varint(replay->data, &pos, end, &offset_delta) != 0) {
+            free(replay->keyframes);
+            replay->keyframes = NULL;
+            return -1;
+        }
+        tick += tick_delta;
+        offset += offset_delta;
+        replay->keyframes[i].tick = tick;
+        replay->keyframes[i].offset = offset;
+    }
+    replay->n_keyframes = (int)count;
+    replay->end = index_offset;
+    return 0;
+}
+
+/* Sem rodapé (servidor terminou a meio): reconstrói o índice varrendo os registos. */
+static void scan_index(replay_t* replay) {
+    int capacity = 0;
+    replay_record_t record;
+    replay_rewind(replay);
+    while (1) {
+        size_t offset = replay->pos;
+        if (replay_next(replay, &record) != 1) break;
+        if (record.type != REC_KEYFRAME) continue;
+        if (replay->n_keyframes == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            replay_keyframe_t* grown = realloc(replay->keyframes, capacity * sizeof(replay_keyframe_t));
+            if (!grown) break;
+            replay->keyframes = grown;
+        }
+        replay->keyframes[replay->n_keyframes].tick = record.tick;
+        replay->keyframes[replay->n_keyframes].offset = offset;
+        replay->n_keyframes++;
+    }
+}
+
+int replay_load(replay_t* replay, const char* path) {
+    memset(replay, 0, sizeof(*replay));
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 18) {
+        fclose(file);
+        return -1;
+    }
+
+    replay->data = malloc(size);
+    if (!replay->data || fread(replay->data, 1, size, file) != (size_t)size) {
+        fclose(file);
+        replay_free(replay);
+        return -1;
+    }
+    fclose(file);
+    replay->size = size;
+    replay->end = size;
+
+    const unsigned char* data = replay->data;
+    if (memcmp(data, REPLAY_MAGIC, 4) != 0 || data[4] == 0 || data[4] > REPLAY_VERSION) {
+        replay_free(replay);
+        return -1;
+    }
+    replay->seed = get_le(data + 5, 8);
+    replay->tempo = (int)(uint32_t)get_le(data + 13, 4);
+
+    size_t name_len = data[17];
+    if (18 + name_len > replay->size) {
+        replay_free(replay);
+        return -1;
+    }
+    memcpy(replay->level_name, data + 18, name_len);
+    replay->level_name[name_len] = '\0';
+    replay->records = 18 + name_len;
+
+    if (data[4] >= 3) {
+        if (replay->records + 6 > replay->size) {
+            replay_free(replay);
+            return -1;
+        }
+        replay->start_points = (int)(uint32_t)get_le(data + replay->records, 4);
+        replay->level_index = (int)get_le(data + replay->records + 4, 2);
+        replay->records += 6;
+    }
+
+    if (load_index(replay) != 0) {
+        scan_index(replay);
+    }
+    replay_rewind(replay);
+    return 0;
+}
+
+void replay_free(replay_t* replay) {
+    free(replay->data);
+    free(replay->keyframes);
+    replay->data = NULL;
+    replay->keyframes = NULL;
+    replay->n_keyframes = 0;
+    replay->size = 0;
+    replay->end = 0;
+}
+
+void replay_rewind(replay_t* replay) {
+    replay->pos = replay->records;
+    replay->last_tick = 0;
+}
+
+int replay_next(replay_t* replay, replay_record_t* record) {
+    if (replay->pos >= replay->end) {
+        return 0;
+    }
+
+    const unsigned char* data = replay->data;
+    size_t end = replay->end;
+    unsigned long delta;
+    record->type = data[replay->pos++];
+    switch (record->type) {
+        case REC_INPUT:
+            if (get_varint(data, &replay->pos, end, &delta) != 0 || replay->pos >= end) return -1;
+            record->command = (char)data[replay->pos++];
+            break;
+        case REC_KEYFRAME: {
+            unsigned long size;
+            if (get_varint(data, &replay->pos, end, &delta) != 0 ||
+                get_varint(data, &replay->pos, end, &size) != 0 ||
+                size > end - replay->pos) {
+                return -1;
+            }
+            record->body = replay->pos;
+            record->body_size = size;
+            replay->pos += size;
+            break;
+        }
+        case REC_END: {
+            unsigned long points;
+            if (get_varint(data, &replay->pos, end, &delta) != 0 || replay->pos >= end) return -1;
+            record->outcome = data[replay->pos++];
+            if (get_varint(data, &replay->pos, end, &points) != 0) return -1;
+            record->points = (int)points;
+            break;
+        }
+        case REC_INDEX:
+            replay->pos = end;  // Índice sem rodapé válido: fim dos registos
+            return 0;
+        default:
+            return -1;
+    }
+
+    replay->last_tick += delta;
+    record->tick = replay->last_tick;
+    return 1;
+}
+
+// ========== MOTOR DE REPLAY ==========
+
+/* Volta ao tick 0 com um board acabado de carregar. */
+static int player_reset(replay_player_t* player) {
+    if (player->board.board) {
+        sched_destroy(&player->sched);
+        unload_level(&player->board);
+    }
+    memset(&player->board, 0, sizeof(player->board));
+    if (load_level(&player->board, 0, player->level_data, player->levels_directory) != 0) {
+        memset(&player->board, 0, sizeof(player->board));
+        return -1;
+    }
+    player->board.seed = player->replay->seed;
+    rng_seed(&player->board.rng, player->replay->seed);
+    player->board.pacmans[0].points = player->replay->start_points;
+
+    if (sched_init(&player->sched, &player->board, 0) != 0) {
+        unload_level(&player->board);
+        memset(&player->board, 0, sizeof(player->board));
+        return -1;
+    }
+
+    player->tick = 0;
+    player->outcome = REPLAY_DISCONNECTED;
+    player->finished = 0;
+    player->inputs = 0;
+    player->ghost_moves = 0;
+    replay_rewind(player->replay);
+    player->have = replay_next(player->replay, &player->record);
+    return 0;
+}
+
+int replay_player_init(replay_player_t* player, replay_t* replay, level_data_t* level_data,
+                       char* levels_directory) {
+    memset(player, 0, sizeof(*player));
+    player->replay = replay;
+    player->level_data = level_data;
+    player->levels_directory = levels_directory;
+    return player_reset(player);
+}
+
+void replay_player_destroy(replay_player_t* player) {
+    if (player->board.board) {
+        sched_destroy(&player->sched);
+        unload_level(&player->board);
+        memset(&player->board, 0, sizeof(player->board));
+    }
+}
+
+int replay_advance(replay_player_t* player, unsigned long until) {
+    replay_record_t* record = &player->record;
+
+    // Mesma ordem que no servidor: jogadas com tick <= próximo tick devido correm primeiro
+    while (!player->finished && player->have == 1) {
+        unsigned long due = sched_next_due(&player->sched);
+
+        if (record->type == REC_KEYFRAME) {
+            player->have = replay_next(player->replay, record);
+            continue;
+        }
+
+        if (record->type == REC_INPUT && (due == SCHED_IDLE || record->tick <= due)) {
+            if (record->tick >= until) break;
+            player->inputs++;
+            player->tick = record->tick;
+            int moved = sched_apply_input(&player->board, record->command);
+            player->have = replay_next(player->replay, record);
+            if (moved == REACHED_PORTAL) {
+                player->outcome = REPLAY_VICTORY;
+                player->finished = 1;
+            } else if (moved == DEAD_PACMAN) {
+                player->outcome = REPLAY_DEAD;
+                player->finished = 1;
+            }
+            continue;
+        }
+
+        if (record->type == REC_END && (due == SCHED_IDLE || due >= record->tick)) {
+            if (record->tick >= until) break;
+            player->tick = record->tick;  // O servidor parou antes deste tick
+            player->finished = 1;
+            break;
+        }
+
+        if (due >= until) break;
+        int acted = 0;
+        int moved = sched_run_tick(&player->sched, &player->board, due, &acted);
+        player->ghost_moves += acted;
+        player->tick = due + 1;
+        if (moved == DEAD_PACMAN) {
+            player->outcome = REPLAY_DEAD;
+            player->finished = 1;
+        }
+    }
+
+    return player->have < 0 ? -1 : 0;
+}
+
+int replay_seek(replay_player_t* player, unsigned long tick, unsigned long* keyframe_tick) {
+    replay_t* replay = player->replay;
+
+    // Último keyframe com tick <= destino (pesquisa binária no índice)
+    int low = 0, high = replay->n_keyframes - 1, found = -1;
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        if (replay->keyframes[mid].tick <= tick) {
+            found = mid;
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+
+    if (found < 0) {
+        if (keyframe_tick) *keyframe_tick = 0;
+        if (player_reset(player) != 0) return -1;
+        return replay_advance(player, tick);
+    }
+
+    replay_keyframe_t* keyframe = &replay->keyframes[found];
+    replay->pos = keyframe->offset;
+    replay_record_t record;
+    if (replay_next(replay, &record) != 1 || record.type != REC_KEYFRAME) {
+        return -1;
+    }
+    // O delta do registo é relativo ao anterior, que não foi lido
+    replay->last_tick = keyframe->tick;
+
+    if (decode_keyframe(replay->data, record.body, record.body + record.body_size,
+                        keyframe->tick, &player->board, &player->sched) != 0) {
+        return -1;
+    }
+
+    player->tick = keyframe->tick;
+    player->outcome = REPLAY_DISCONNECTED;
+    player->finished = 0;
+    player->inputs = 0;
+    player->ghost_moves = 0;
+    player->have = replay_next(replay, &player->record);
+    if (keyframe_tick) *keyframe_tick = keyframe->tick;
+    return replay_advance(player, tick);
+}
+
+int replay_run(replay_t* replay, level_data_t* level_data, char* levels_directory,
+               replay_result_t* result) {
+    memset(result, 0, sizeof(*result));
+    result->expected_outcome = -1;
+
+    replay_player_t player;
+    if (replay_player_init(&player, replay, level_data, levels_directory) != 0) {
+        return -1;
+    }
+    int rc = replay_advance(&player, SCHED_IDLE);
+
+    // Procurar o registo final (o jogo pode ter acabado antes de o ler)
+    while (player.have == 1 && player.record.type != REC_END) {
+        player.have = replay_next(replay, &player.record);
+    }
+    if (player.have == 1) {
+        result->has_end = 1;
+        result->expected_ticks = player.record.tick;
+        result->expected_outcome = player.record.outcome;
+        result->expected_points = player.record.points;
+    }
+
+    result->ticks = player.tick;
+    result->inputs = player.inputs;
+    result->ghost_moves = player.ghost_moves;
+    result->outcome = player.outcome;
+    result->points = player.board.pacmans[0].points;
+
+    replay_player_destroy(&player);
+    return (rc != 0 || player.have < 0) ? -1 : 0;
+}
@@ -0,0 +1,124 @@
+#include "sched.h"
+#include "trace.h"
+#include <stdlib.h>
+
+static int entry_before(const sched_entry_t* a, const sched_entry_t* b) {
+    if (a->due != b->due) return a->due < b->due;
+    return a->ghost_index < b->ghost_index;  // Desempate fixo: ordem reprodutível
+}
+
+static void sift_up(entity_sched_t* sched, int i) {
+    sched_entry_t entry = sched->heap[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!entry_before(&entry, &sched->heap[parent])) break;
+        sched->heap[i] = sched->heap[parent];
+        i = parent;
+    }
+    sched->heap[i] = entry;
+}
+
+static void sift_down(entity_sched_t* sched, int i) {
+    sched_entry_t entry = sched->heap[i];
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= sched->size) break;
+        if (child + 1 < sched->size && entry_before(&sched->heap[child + 1], &sched->heap[child])) {
+            child++;
+        }
+        if (!entry_before(&sched->heap[child], &entry)) break;
+        sched->heap[i] = sched->heap[child];
+        i = child;
+    }
+    sched->heap[i] = entry;
+}
+
+int sched_init(entity_sched_t* sched, board_t* board, unsigned long first_tick) {
+    sched->size = 0;
+    sched->heap = malloc((board->n_ghosts > 0 ? board->n_ghosts : 1) * sizeof(sched_entry_t));
+    if (!sched->heap) {
+        return -1;
+    }
+
+    for (int i = 0; i < board->n_ghosts; i++) {
+        // Ghosts sem comandos nunca agem
+        if (board->ghosts[i].n_moves <= 0) continue;
+        sched->heap[sched->size].due = first_tick + board->ghosts[i].waiting;
+        sched->heap[sched->size].ghost_index = i;
+        sched->size++;
+        sift_up(sched, sched->size - 1);
+    }
+    return 0;
+}
+
+void sched_destroy(entity_sched_t* sched) {
+    free(sched->heap);
+    sched->heap = NULL;
+    sched->size = 0;
+}
+
+void sched_restore(entity_sched_t* sched, board_t* board, const unsigned long* due) {
+    sched->size = 0;
+    for (int i = 0; i < board->n_ghosts; i++) {
+        if (due[i] == SCHED_IDLE) continue;
+        sched->heap[sched->size].due = due[i];
+        sched->heap[sched->size].ghost_index = i;
+        sched->size++;
+        sift_up(sched, sched->size - 1);
+    }
+}
+
+unsigned long sched_due(entity_sched_t* sched, int ghost_index) {
+    for (int i = 0; i < sched->size; i++) {
+        if (sched->heap[i].ghost_index == ghost_index) {
+            return sched->heap[i].due;
+        }
+    }
+    return SCHED_IDLE;
+}
+
+unsigned long sched_next_due(entity_sched_t* sched) {
+    return sched->size > 0 ? sched->heap[0].due : SCHED_IDLE;
+}
+
+int sched_run_tick(entity_sched_t* sched, board_t* board, unsigned long tick, int* n_acted) {
+    int outcome = VALID_MOVE;
+    int acted = 0;
+
+    while (sched->size > 0 && sched->heap[0].due <= tick) {
+        int ghost_index = sched->heap[0].ghost_index;
+        ghost_t* ghost = &board->ghosts[ghost_index];
+
+        // A espera já decorreu no heap
+        ghost->waiting = 0;
+
+        command_t* play = &ghost->moves[ghost->current_move % ghost->n_moves];
+        uint64_t move_start = trace_begin();
+        int result;
+        if (ghost->charged) {
+            result = move_ghost_charged(board, ghost_index, play->command);
+        } else {
+            result = move_ghost(board, ghost_index, play);
+        }
+        trace_end("ghost_move", move_start);
+        if (result == DEAD_PACMAN) {
+            outcome = DEAD_PACMAN;
+        }
+        acted++;
+
+        // move_ghost deixa waiting = passo após um movimento; T e C voltam no tick seguinte
+        sched->heap[0].due = tick + 1 + ghost->waiting;
+        sift_down(sched, 0);
+    }
+
+    if (n_acted) *n_acted = acted;
+    return outcome;
+}
+
+int sched_apply_input(board_t* board, char command) {
+    command_t cmd;
+    cmd.command = command;
+    cmd.turns = 1;
+    cmd.turns_left = 1;
+    return move_pacman(board, 0, &cmd);
+}
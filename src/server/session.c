@@ -0,0 +1,959 @@
+#include "session.h"
+#include "frame.h"
+#include "protocol.h"
+#include "sched.h"
+#include "replay.h"
+#include "metrics.h"
+#include "trace.h"
+#include "ranking.h"
+#include "leaderboard.h"
+#include "log.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+
+// ========== FUNÇÕES AUXILIARES ==========
+
+static void block_sigusr1(void) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+}
+
+/* Estaciona a thread até ao próximo jogo da sessão (o primeiro começa quando
+a sessão é ligada a um cliente). *game é o último jogo que a thread jogou.
+Devolve 1 se há um jogo novo, 0 se a sessão vai ser libertada. */
+static int wait_for_game(game_sync_t* sync, unsigned int* game) {
+    board_lock(sync);
+    while (sync->game_id == *game && !sync->closing) {
+        board_wait(&sync->start_cond, sync);
+    }
+    int started = !sync->closing;
+    *game = sync->game_id;
+    board_unlock(sync);
+    return started;
+}
+
+/* Acorda a thread do pacman se estiver bloqueada à espera de pedidos. Um
+byte que sobre só causa uma verificação extra do estado do jogo. */
+static void wake_pacman(game_sync_t* sync) {
+    char byte = 1;
+    ssize_t n = write(sync->pacman_wake[1], &byte, 1);  // Pipe cheio: já há um despertar pendente
+    (void)n;
+}
+
+// Ghosts e updates: o jogo atual acabou para esta thread
+static void finish_game(game_sync_t* sync) {
+    board_lock(sync);
+    sync->playing--;
+    pthread_cond_broadcast(&sync->game_done_cond);
+    board_unlock(sync);
+
+    // O jogo pode ter acabado sem jogada do cliente (morte por um ghost)
+    wake_pacman(sync);
+}
+
+// Leitor com buffer do pipe de pedidos: as mensagens têm tamanhos diferentes por opcode
+typedef struct {
+    char buf[64];
+    int start;
+    int end;
+} request_reader_t;
+
+static int request_size(char op) {
+    switch (op) {
+        case OP_CODE_DISCONNECT: return MSG_DISCONNECT_SIZE;
+        case OP_CODE_PLAY: return MSG_PLAY_SIZE;
+        case OP_CODE_PLAY_SEQ: return MSG_PLAY_SEQ_SIZE;
+        case OP_CODE_NEW_GAME: return MSG_NEW_GAME_SIZE;
+        default: return 1;  // Opcode desconhecido: descartar o byte
+    }
+}
+
+#define REQUEST_WOKEN -1  // read_request: acordada por wake_pacman
+
+/* Copia a próxima mensagem completa para msg (pelo menos MSG_PLAY_SEQ_SIZE bytes).
+Com timeout_ms >= 0, desiste se o pipe ficar esse tempo sem dados.
+Devolve o seu tamanho, REQUEST_WOKEN se wake_fd acordou a espera, ou 0 se o
+cliente fechou o pipe, a leitura falhou ou o prazo passou. */
+static int read_request(int fd, int wake_fd, request_reader_t* reader, char* msg, int timeout_ms) {
+    while (1) {
+        int available = reader->end - reader->start;
+        if (available > 0) {
+            int size = request_size(reader->buf[reader->start]);
+            if (available >= size) {
+                memcpy(msg, reader->buf + reader->start, size);
+                reader->start += size;
+                return size;
+            }
+        }
+
+        // Mensagem incompleta: compactar e ler mais
+        memmove(reader->buf, reader->buf + reader->start, available);
+        reader->start = 0;
+        reader->end = available;
+        struct pollfd pfds[2] = {{.fd = fd, .events = POLLIN}, {.fd = wake_fd, .events = POLLIN}};
+        int ready = poll(pfds, 2, timeout_ms);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            return 0;
+        }
+        if (pfds[1].revents & POLLIN) {
+            char drain[16];
+            while (read(wake_fd, drain, sizeof(drain)) > 0) {
+            }
+            return REQUEST_WOKEN;
+        }
+        ssize_t n = read(fd, reader->buf + reader->end, sizeof(reader->buf) - reader->end);
+        if (n <= 0) {
+            return 0;
+        }
+        reader->end += n;
+    }
+}
+
+// Devolve ao leitor a última mensagem lida (os bytes continuam no buffer)
+static void unread_request(request_reader_t* reader, int size) {
+    reader->start -= size;
+}
+
+// ========== THREADS DO JOGO (POR SESSÃO) ==========
+
+/* Aplica as jogadas do cliente até o jogo acabar. Devolve 1 se o cliente
+continua ligado (uma mensagem lida depois do fim volta para o leitor), 0 se
+desligou. */
+static int play_game(session_t* session, board_t* board, request_reader_t* reader) {
+    game_sync_t* sync = &session->sync;
+
+    while (1) {
+        // Ler comando do pipe
+        char msg[MSG_PLAY_SEQ_SIZE];
+        int n = read_request(session->req_pipe_fd, sync->pacman_wake[0], reader, msg, -1);
+
+        if (n == REQUEST_WOKEN) {
+            // Um ghost pode ter acabado o jogo sem o cliente enviar nada
+            board_lock(sync);
+            int running = sync->game_running;
+            board_unlock(sync);
+            if (!running) {
+                return 1;
+            }
+            continue;
+        }
+        if (n == 0 || msg[0] == OP_CODE_DISCONNECT) {
+            // Cliente desconectou
+            board_lock(sync);
+            sync->game_running = 0;
+            pthread_cond_broadcast(&sync->display_ready_cond);
+            pthread_cond_broadcast(&sync->start_cond);
+            board_unlock(sync);
+            tick_wake_signal(&sync->ghost_wake);
+            return 0;
+        }
+
+        // Mover pacman
+        uint64_t input_start = trace_begin();
+        uint64_t wait_start = metrics_now();
+        board_lock(sync);
+        uint64_t locked_at = metrics_lock_acquired(wait_start);
+
+        if (sync->level_complete && sync->game_running) {
+            // Portal alcançado: a jogada é para o nível seguinte, que a thread de updates está a montar
+            while (sync->level_complete && sync->game_running) {
+                board_wait(&sync->start_cond, sync);
+            }
+            locked_at = metrics_now();  // A espera na condição não conta como posse
+        }
+        if (!sync->game_running) {
+            // Um ghost acabou o jogo enquanto se esperava: a mensagem é para depois do jogo
+            metrics_lock_released(locked_at);
+            board_unlock(sync);
+            unread_request(reader, n);
+            return 1;
+        }
+        if (msg[0] != OP_CODE_PLAY && msg[0] != OP_CODE_PLAY_SEQ) {
+            metrics_lock_released(locked_at);
+            board_unlock(sync);
+            continue;
+        }
+
+        char command = msg[1];
+        if (msg[0] == OP_CODE_PLAY_SEQ) {
+            memcpy(&sync->last_seq, msg + 2, 4);
+            sync->seq_frames = 1;
+        }
+
+        if (session->recorder) {
+            recorder_input(session->recorder, sync->tick, command);
+        }
+        int points = board->pacmans[0].points;
+        int result = sched_apply_input(board, command);
+        if (board->pacmans[0].points != points) {
+            ranking_update(session->ranking_handle, board->pacmans[0].points);
+        }
+
+        if (result == REACHED_PORTAL) {
+            sync->level_complete = 1;
+            if (session->level_index + 1 >= session->level_limit) {
+                sync->game_running = 0;  // Último nível: fim do jogo
+            }
+        } else if (result == DEAD_PACMAN) {
+            sync->pacman_dead = 1;
+            sync->game_running = 0;
+        }
+        int over = !sync->game_running;
+
+        sync->display_ready = 1;
+        pthread_cond_signal(&sync->display_ready_cond);
+        metrics_lock_released(locked_at);
+        board_unlock(sync);
+        trace_end("input", input_start);
+
+        if (over) {
+            tick_wake_signal(&sync->ghost_wake);
+            return 1;
+        }
+    }
+}
+
+static long long monotonic_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/* Espera pelo pedido do cliente depois do fim do jogo. Devolve o modo de
+OP_CODE_NEW_GAME, ou NEXT_GAME_CLOSE com DISCONNECT, EOF, sessão a fechar ou
+SESSION_IDLE_TIMEOUT_MS desde o fim do jogo. Jogadas atrasadas são
+descartadas e não adiam o prazo. */
+static int read_next_game(session_t* session, request_reader_t* reader) {
+    game_sync_t* sync = &session->sync;
+    long long deadline = monotonic_ms() + SESSION_IDLE_TIMEOUT_MS;
+    if (sync->closing) {
+        return NEXT_GAME_CLOSE;
+    }
+
+    while (1) {
+        long long remaining = deadline - monotonic_ms();
+        if (remaining <= 0) {
+            return NEXT_GAME_CLOSE;
+        }
+        char msg[MSG_PLAY_SEQ_SIZE];
+        int n = read_request(session->req_pipe_fd, sync->pacman_wake[0], reader, msg, (int)remaining);
+
+        if (n == REQUEST_WOKEN) {
+            if (sync->closing) {
+                return NEXT_GAME_CLOSE;
+            }
+            continue;
+        }
+        if (n == 0 || msg[0] == OP_CODE_DISCONNECT) {
+            return NEXT_GAME_CLOSE;
+        }
+        if (msg[0] == OP_CODE_NEW_GAME) {
+            return msg[1] == NEW_GAME_NEXT_LEVEL ? NEW_GAME_NEXT_LEVEL : NEW_GAME_RESTART;
+        }
+    }
+}
+
+// Thread do Pacman - lê comandos do pipe de pedidos, jogo após jogo
+static void* pacman_thread_func(void* arg) {
+    pacman_thread_args_t* args = (pacman_thread_args_t*)arg;
+    board_t* board = (board_t*)args->board;
+    game_sync_t* sync = args->sync;
+    session_t* session = (session_t*)((char*)sync - offsetof(session_t, sync));
+
+    block_sigusr1();
+
+    // O leitor dura toda a ligação: bytes lidos a mais passam para o jogo seguinte
+    request_reader_t reader = {.start = 0, .end = 0};
+    unsigned int game = 0;
+
+    while (wait_for_game(sync, &game)) {
+        trace_thread("pacman", session->client_id);
+
+        int next = play_game(session, board, &reader) ? read_next_game(session, &reader) : NEXT_GAME_CLOSE;
+
+        board_lock(sync);
+        sync->next_game = next;
+        pthread_cond_broadcast(&sync->game_done_cond);
+        board_unlock(sync);
+    }
+
+    free(args);
+    return NULL;
+}
+
+/* Sem escalonador os ghosts não podem agir: o jogo acaba em vez de ficar
+parado. O pacman é acordado por finish_game. */
+static void abort_ghosts(session_t* session) {
+    game_sync_t* sync = &session->sync;
+    log_error("Client %d: ghost scheduler init failed, ending the game\n", session->client_id);
+
+    board_lock(sync);
+    sync->game_running = 0;
+    pthread_cond_broadcast(&sync->display_ready_cond);
+    pthread_cond_broadcast(&sync->start_cond);
+    board_unlock(sync);
+}
+
+// Um jogo dos ghosts - um min-heap por sessão decide quem age em cada tick
+static void run_ghosts(session_t* session) {
+    board_t* board = (board_t*)session->board;
+    game_sync_t* sync = &session->sync;
+
+    entity_sched_t sched;
+    if (sched_init(&sched, board, 0) != 0) {
+        abort_ghosts(session);
+        return;
+    }
+    unsigned int level = sync->level_id;
+
+    // Prazos absolutos a partir do epoch do nível; só acorda em ticks com ghosts a agir
+    tick_clock_t clock;
+    tick_clock_init(&clock, &session->epoch, board->tempo, CLOCK_MAX_CATCHUP);
+    tick_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+
+    while (sync->game_running) {
+        // Lido antes do estado: uma passagem de nível ou o fim do jogo a seguir acorda a espera
+        unsigned long seen = tick_wake_seen(&sync->ghost_wake);
+        unsigned long next = sched_next_due(&sched);
+        unsigned long tick;
+        if (next == SCHED_IDLE) {
+            // Nenhum ghost com comandos neste nível
+            tick_wake_wait(&sync->ghost_wake, seen);
+            tick = TICK_CLOCK_WOKEN;
+        } else {
+            tick_clock_skip_to(&clock, next);
+            tick = tick_clock_wait_wake(&clock, &sync->ghost_wake, seen);
+        }
+
+        uint64_t wait_start = metrics_now();
+        board_lock(sync);
+        uint64_t locked_at = metrics_lock_acquired(wait_start);
+        if (!sync->game_running) {
+            metrics_lock_released(locked_at);
+            board_unlock(sync);
+            break;
+        }
+
+        if (sync->level_id != level) {
+            // Nível novo no mesmo board: escalonador e relógio a partir do seu epoch
+            sched_destroy(&sched);
+            int failed = sched_init(&sched, board, 0) != 0;
+            tick_stats_merge(&stats, &clock.stats);
+            tick_clock_init(&clock, &session->epoch, board->tempo, CLOCK_MAX_CATCHUP);
+            level = sync->level_id;
+            metrics_lock_released(locked_at);
+            board_unlock(sync);
+            if (failed) {
+                session->tick_stats = stats;
+                abort_ghosts(session);
+                return;
+            }
+            continue;
+        }
+        if (tick == TICK_CLOCK_WOKEN || sync->level_complete) {
+            // Acordada sem tick, ou à espera do nível seguinte: os ghosts não agem
+            metrics_lock_released(locked_at);
+            board_unlock(sync);
+            continue;
+        }
+
+        int acted = 0;
+        uint64_t tick_start = metrics_now();
+        uint64_t tick_trace = trace_begin();
+        if (sched_run_tick(&sched, board, tick, &acted) == DEAD_PACMAN) {
+            sync->pacman_dead = 1;
+            sync->game_running = 0;
+        }
+        trace_end("tick", tick_trace);
+        metrics_observe(METRIC_TICK_DURATION, metrics_now() - tick_start);
+        metrics_count(METRIC_TICKS, 1);
+        sync->tick = tick + 1;
+        if (session->recorder) {
+            recorder_tick(session->recorder, sync->tick, board, &sched);
+        }
+
+        if (acted > 0) {
+            sync->display_ready = 1;
+            pthread_cond_signal(&sync->display_ready_cond);
+        }
+        metrics_lock_released(locked_at);
+        board_unlock(sync);
+    }
+
+    tick_stats_merge(&stats, &clock.stats);
+    session->tick_stats = stats;
+    sched_destroy(&sched);
+}
+
+// Thread dos Ghosts - estacionada entre jogos
+static void* ghost_thread_func(void* arg) {
+    session_t* session = (session_t*)arg;
+    game_sync_t* sync = &session->sync;
+
+    block_sigusr1();
+
+    unsigned int game = 0;
+    while (wait_for_game(sync, &game)) {
+        trace_thread("ghosts", session->client_id);
+        run_ghosts(session);
+        finish_game(sync);
+    }
+    return NULL;
+}
+
+/* Serializa o board em frame_buf (chamar com board_mutex bloqueado). Depois da
+primeira jogada com sequência, os frames indicam a última aplicada e o tick. */
+static int encode_frame(session_t* session) {
+    board_t* board = (board_t*)session->board;
+    game_sync_t* sync = &session->sync;
+    int victory = sync->level_complete ? 1 : 0;
+    // Fim do jogo (morte, último nível ou desconexão): o cliente deixa de esperar frames
+    int game_over = (sync->pacman_dead || !sync->game_running) ? 1 : 0;
+
+    uint64_t start = trace_begin();
+    int size;
+    if (sync->seq_frames) {
+        size = encode_board_frame_seq(board, victory, game_over, sync->last_seq,
+                                      (unsigned int)sync->tick, session->frame_buf);
+    } else {
+        size = encode_board_frame(board, victory, game_over, session->frame_buf);
+    }
+    trace_end("frame_encode", start);
+    return size;
+}
+
+// Escreve o frame serializado em frame_buf; escritas falhadas ou incompletas contam como perdidas
+static void send_frame(session_t* session, int msg_size) {
+    uint64_t start = trace_begin();
+    ssize_t n = write(session->notif_pipe_fd, session->frame_buf, msg_size);
+    trace_end("pipe_write", start);
+    if (n == msg_size) {
+        metrics_count(METRIC_FRAMES_SENT, 1);
+        metrics_count(METRIC_FRAME_BYTES, (unsigned long)n);
+    } else {
+        metrics_count(METRIC_FRAMES_DROPPED, 1);
+    }
+}
+
+// ========== NÍVEIS ==========
+
+// Gravação opcional para replay determinístico do nível atual (nível, seed e jogadas)
+static void open_recorder(session_t* session) {
+    const char* record_dir = getenv(REPLAY_RECORD_DIR_ENV);
+    if (record_dir && *record_dir) {
+        session->recorder = recorder_open(record_dir, session->client_id, (board_t*)session->board,
+                                          session->level_index);
+    }
+}
+
+/* Regista o resultado do nível atual: uma entrada no leaderboard e o fim da
+sua gravação. Só a primeira chamada por nível conta. */
+static void finish_level(session_t* session, int outcome) {
+    board_t* board = (board_t*)session->board;
+    if (session->level_finished) {
+        return;
+    }
+    session->level_finished = 1;
+
+    // Só enfileira: o disco é escrito pela thread do leaderboard
+    leaderboard_submit(session->client_id, board->level_name, board->pacmans[0].points,
+                       (unsigned int)session->sync.tick, outcome);
+
+    if (session->recorder) {
+        recorder_end(session->recorder, session->sync.tick, outcome, board->pacmans[0].points);
+        recorder_close(session->recorder);
+        session->recorder = NULL;
+    }
+}
+
+// Guarda um modelo sem uso para o próximo pré-carregamento (basta um de reserva)
+static void recycle_template(session_t* session, board_t* template) {
+    if (!template) {
+        return;
+    }
+    if (!session->spare_template) {
+        session->spare_template = template;
+        return;
+    }
+    unload_level(template);
+    free(template);
+}
+
+/* Carrega o nível index num modelo, reaproveitando o de reserva. Lento (lê
+os ficheiros .p e .m): chamar fora do board_mutex. */
+static board_t* load_template(session_t* session, board_t* spare, int index) {
+    level_list_t* levels = (level_list_t*)session->levels;
+    if (spare) {
+        unload_level(spare);
+    } else {
+        spare = malloc(sizeof(board_t));
+        if (!spare) {
+            return NULL;
+        }
+    }
+    if (load_level(spare, 0, &levels->levels[index], levels->directory) != 0) {
+        free(spare);
+        return NULL;
+    }
+    return spare;
+}
+
+/* Copia o modelo do nível atual para o board com os pontos dados. O frame_buf
+cresce antes da cópia, para nunca ficar mais pequeno do que o board. Só com as
+threads estacionadas ou pela thread de updates, com board_mutex. */
+static int install_level(session_t* session, int points) {
+    board_t* board = (board_t*)session->board;
+    board_t* template = (board_t*)session->level_template;
+
+    int size = frame_seq_size(template);
+    if (size > session->frame_buf_size) {
+        char* frame_buf = realloc(session->frame_buf, size);
+        if (!frame_buf) {
+            return -1;
+        }
+        session->frame_buf = frame_buf;
+        session->frame_buf_size = size;
+    }
+    if (copy_level(board, template) != 0) {
+        return -1;
+    }
+    board->pacmans[0].points = points;
+    return 0;
+}
+
+/* Pré-carrega o nível seguinte enquanto o atual é jogado, para a passagem de
+nível ser só uma cópia. Corre na gestora, dentro de session_wait. */
+static void prefetch_next_level(session_t* session) {
+    game_sync_t* sync = &session->sync;
+
+    board_lock(sync);
+    int index = session->level_index + 1;
+    board_t* spare = (board_t*)session->spare_template;
+    session->spare_template = NULL;
+    board_unlock(sync);
+
+    // Só esta gestora escreve next_template e só a passagem de nível muda level_index
+    uint64_t start = trace_begin();
+    board_t* template = load_template(session, spare, index);
+    trace_end("level_prefetch", start);
+
+    board_lock(sync);
+    if (template) {
+        session->next_template = template;
+    } else {
+        // O jogo acaba no portal deste nível
+        log_warn("Client %d: failed to load level %d, it will not be played\n", session->client_id, index);
+        session->level_limit = index;
+    }
+    pthread_cond_broadcast(&sync->start_cond);
+    board_unlock(sync);
+}
+
+static int needs_prefetch(session_t* session) {
+    return !session->next_template && session->level_index + 1 < session->level_limit;
+}
+
+/* Passa ao nível seguinte depois de enviado o frame de vitória: o modelo
+pré-carregado é copiado sobre o board com os pontos e a seed do jogo, e o
+nível recomeça no tick 0. Corre na thread de updates; o pacman e os ghosts
+esperam que level_complete volte a 0. */
+static void advance_level(session_t* session) {
+    board_t* board = (board_t*)session->board;
+    game_sync_t* sync = &session->sync;
+    uint64_t switch_start = metrics_now();
+    uint64_t trace_start = trace_begin();
+
+    board_lock(sync);
+    while (sync->game_running && needs_prefetch(session)) {
+        // Portal logo no início do nível: o pré-carregamento ainda não acabou
+        board_wait(&sync->start_cond, sync);
+    }
+    if (!sync->game_running) {
+        board_unlock(sync);
+        return;
+    }
+
+    int points = board->pacmans[0].points;
+    uint64_t seed = board->seed;
+
+    // Sem nível seguinte o board fica intacto e a vitória é registada em session_wait
+    int failed = !session->next_template;
+    if (!failed) {
+        finish_level(session, REPLAY_VICTORY);
+        recycle_template(session, (board_t*)session->level_template);
+        session->level_template = session->next_template;
+        session->next_template = NULL;
+        session->level_index++;
+        failed = install_level(session, points) != 0;
+    }
+    if (failed) {
+        // Sem nível seguinte utilizável: o jogo acaba nesta vitória
+        sync->game_running = 0;
+        pthread_cond_broadcast(&sync->display_ready_cond);
+        pthread_cond_broadcast(&sync->start_cond);
+        board_unlock(sync);
+        tick_wake_signal(&sync->ghost_wake);
+        return;
+    }
+
+    // Cada nível recomeça o gerador com a seed do jogo: as gravações por nível continuam reproduzíveis
+    board->seed = seed;
+    rng_seed(&board->rng, seed);
+    clock_gettime(CLOCK_MONOTONIC, &session->epoch);
+    sync->level_complete = 0;
+    sync->tick = 0;
+    sync->level_id++;
+    sync->display_ready = 1;
+    session->level_finished = 0;
+    open_recorder(session);
+
+    pthread_cond_broadcast(&sync->start_cond);      // Pacman à espera do nível
+    pthread_cond_broadcast(&sync->game_done_cond);  // Gestora: pré-carregar o seguinte
+    board_unlock(sync);
+    tick_wake_signal(&sync->ghost_wake);
+
+    trace_end("level_switch", trace_start);
+    metrics_observe(METRIC_LEVEL_SWITCH, metrics_now() - switch_start);
+}
+
+// ========== THREAD DE UPDATES ==========
+
+// Envia periodicamente o estado ao cliente durante um jogo e no fim a mensagem final
+static void send_updates(session_t* session) {
+    board_t* board = (board_t*)session->board;
+    game_sync_t* sync = &session->sync;
+
+    // Limita o envio a um frame por tick; sem recuperação de ticks perdidos
+    tick_clock_t clock;
+    tick_clock_init(&clock, &session->epoch, board->tempo, 0);
+
+    while (sync->game_running) {
+        board_lock(sync);
+
+        while (!sync->display_ready && sync->game_running) {
+            board_wait(&sync->display_ready_cond, sync);
+        }
+
+        if (!sync->game_running) {
+            board_unlock(sync);
+            break;
+        }
+        uint64_t locked_at = metrics_now();  // A espera na condição não conta como posse
+
+        // Serializar board no buffer pré-alocado da sessão
+        int msg_size = encode_frame(session);
+        int level_done = sync->level_complete;
+
+        sync->display_ready = 0;
+        metrics_lock_released(locked_at);
+        board_unlock(sync);
+
+        // Enviar mensagem ao cliente
+        send_frame(session, msg_size);
+
+        if (level_done) {
+            // Frame de vitória enviado: o primeiro frame do nível seguinte sai sem esperar pelo tick
+            advance_level(session);
+            tick_clock_init(&clock, &session->epoch, board->tempo, 0);
+            continue;
+        }
+
+        // Aguardar próximo ciclo (prazo absoluto, não acumula o tempo de envio)
+        tick_clock_wait(&clock);
+    }
+
+    // Enviar mensagem final (game over ou victory)
+    board_lock(sync);
+    int msg_size = encode_frame(session);
+    board_unlock(sync);
+
+    send_frame(session, msg_size);
+}
+
+// Thread de atualização do board - estacionada entre jogos
+static void* board_update_thread_func(void* arg) {
+    session_t* session = (session_t*)arg;
+    game_sync_t* sync = &session->sync;
+
+    block_sigusr1();
+
+    unsigned int game = 0;
+    while (wait_for_game(sync, &game)) {
+        trace_thread("update", session->client_id);
+        send_updates(session);
+        finish_game(sync);
+    }
+    return NULL;
+}
+
+// ========== CICLO DE VIDA DA SESSÃO ==========
+
+session_t* session_prepare(level_list_t* levels) {
+    session_t* session = calloc(1, sizeof(session_t));
+    if (!session) {
+        return NULL;
+    }
+    session->req_pipe_fd = -1;
+    session->notif_pipe_fd = -1;
+    session->ranking_handle = -1;
+    session->levels = levels;
+    session->level_index = 0;
+    session->level_limit = levels->n_levels;
+
+    // Criar board: o modelo guarda o estado inicial do nível, que cada jogo copia
+    uint64_t load_start = trace_begin();
+    board_t* template = load_template(session, NULL, 0);
+    if (!template) {
+        free(session);
+        return NULL;
+    }
+    board_t* board = calloc(1, sizeof(board_t));
+    if (!board || copy_level(board, template) != 0) {
+        if (board) unload_level(board);
+        free(board);
+        unload_level(template);
+        free(template);
+        free(session);
+        return NULL;
+    }
+    trace_end("level_load", load_start);
+    session->board = board;
+    session->level_template = template;
+
+    session->frame_buf_size = frame_seq_size(board);  // Cabe também o frame sem sequência
+    session->frame_buf = malloc(session->frame_buf_size);
+
+    // Inicializar sincronização
+    init_game_sync(&session->sync);
+    session->sync.game_running = 1;
+    session->sync.display_ready = 1;
+
+    // Criar threads do jogo (ficam estacionadas em start_cond)
+    // Board update thread
+    pthread_create(&session->board_update_thread, NULL, board_update_thread_func, session);
+
+    // Pacman thread
+    pacman_thread_args_t* pacman_args = malloc(sizeof(pacman_thread_args_t));
+    pacman_args->board = board;
+    pacman_args->sync = &session->sync;
+    pthread_create(&session->pacman_thread, NULL, pacman_thread_func, pacman_args);
+
+    // Ghost thread (uma por sessão, independentemente do número de ghosts)
+    pthread_create(&session->ghost_thread, NULL, ghost_thread_func, session);
+
+    session->threads_running = 1;
+    return session;
+}
+
+int session_bind(session_t* session, connection_request_t* request) {
+    strcpy(session->req_pipe_path, request->req_pipe_path);
+    strcpy(session->notif_pipe_path, request->notif_pipe_path);
+
+    // Abrir pipes do cliente
+    session->req_pipe_fd = open(request->req_pipe_path, O_RDONLY);
+    if (session->req_pipe_fd < 0) {
+        perror("Failed to open request pipe");
+        return -1;
+    }
+
+    session->notif_pipe_fd = open(request->notif_pipe_path, O_WRONLY);
+    if (session->notif_pipe_fd < 0) {
+        perror("Failed to open notification pipe");
+        close(session->req_pipe_fd);
+        session->req_pipe_fd = -1;
+        return -1;
+    }
+
+    // Enviar resposta CONNECT
+    char response[2];
+    response[0] = OP_CODE_CONNECT;
+    response[1] = 0;  // Success
+    write(session->notif_pipe_fd, response, 2);
+
+    session->active = 1;
+    return 0;
+}
+
+uint64_t session_choose_seed(void) {
+    const char* env = getenv("PACMAN_SEED");
+    if (env && *env) {
+        return strtoull(env, NULL, 0);
+    }
+
+    // splitmix64 sobre relógio, contador e endereço de pilha
+    static unsigned long counter = 0;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t z = ((uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec)
+               ^ ((uint64_t)__atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED) << 32)
+               ^ (uint64_t)(uintptr_t)&now;
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void session_start(session_t* session, uint64_t seed) {
+    board_t* board = (board_t*)session->board;
+
+    board_lock(&session->sync);
+    board->seed = seed;
+    rng_seed(&board->rng, seed);
+
+    session->level_finished = 0;
+    open_recorder(session);
+    clock_gettime(CLOCK_MONOTONIC, &session->epoch);
+    session->ranking_handle = ranking_join(session->client_id, board->pacmans[0].points);
+
+    game_sync_t* sync = &session->sync;
+    sync->game_running = 1;
+    sync->level_complete = 0;
+    sync->pacman_dead = 0;
+    sync->display_ready = 1;
+    sync->tick = 0;
+    sync->playing = 2;  // Ghosts e updates
+    sync->next_game = NEXT_GAME_PENDING;
+    sync->game_id++;
+    pthread_cond_broadcast(&sync->start_cond);
+    board_unlock(&session->sync);
+
+    metrics_count(METRIC_SESSIONS_STARTED, 1);
+    metrics_gauge_add(METRIC_ACTIVE_SESSIONS, 1);
+}
+
+/* Termina o jogo e junta todas as threads. */
+static void stop_threads(session_t* session) {
+    board_lock(&session->sync);
+    session->sync.closing = 1;
+    session->sync.game_running = 0;
+    pthread_cond_broadcast(&session->sync.start_cond);
+    pthread_cond_broadcast(&session->sync.display_ready_cond);
+    board_unlock(&session->sync);
+    tick_wake_signal(&session->sync.ghost_wake);
+    wake_pacman(&session->sync);
+
+    pthread_join(session->pacman_thread, NULL);
+    pthread_join(session->ghost_thread, NULL);
+    pthread_join(session->board_update_thread, NULL);
+
+    session->threads_running = 0;
+}
+
+void session_wait(session_t* session) {
+    // Morte, desconexão ou último portal; com playing a 0 a mensagem final já foi enviada
+    game_sync_t* sync = &session->sync;
+    board_lock(sync);
+    while (sync->game_running || sync->playing > 0) {
+        if (sync->game_running && needs_prefetch(session)) {
+            // A gestora está livre durante o jogo: prepara já o nível seguinte
+            board_unlock(sync);
+            prefetch_next_level(session);
+            board_lock(sync);
+            continue;
+        }
+        board_wait(&sync->game_done_cond, sync);
+    }
+    board_unlock(sync);
+
+    metrics_gauge_add(METRIC_ACTIVE_SESSIONS, -1);
+    ranking_leave(session->ranking_handle);
+    session->ranking_handle = -1;
+
+    int outcome = sync->level_complete ? REPLAY_VICTORY :
+                  sync->pacman_dead ? REPLAY_DEAD : REPLAY_DISCONNECTED;
+    finish_level(session, outcome);
+}
+
+int session_next_game(session_t* session) {
+    game_sync_t* sync = &session->sync;
+    board_lock(sync);
+    while (sync->next_game == NEXT_GAME_PENDING) {
+        board_wait(&sync->game_done_cond, sync);
+    }
+    int next = sync->next_game;
+    board_unlock(sync);
+    return next;
+}
+
+int session_reset(session_t* session, int mode) {
+    level_list_t* levels = (level_list_t*)session->levels;
+    board_t* board = (board_t*)session->board;
+    int index = 0;
+    int points = 0;
+    if (mode == NEW_GAME_NEXT_LEVEL) {
+        // Depois do último nível volta ao primeiro, com os pontos
+        index = (session->level_index + 1) % levels->n_levels;
+        points = board->pacmans[0].points;
+    }
+
+    // As threads estão estacionadas: o board, os modelos e o frame_buf são reaproveitados
+    board_t* next = (board_t*)session->next_template;
+    session->next_template = NULL;
+    if (index != session->level_index) {
+        board_t* template = NULL;
+        if (next && index == session->level_index + 1) {
+            template = next;
+            next = NULL;
+        } else {
+            board_t* spare = (board_t*)session->spare_template;
+            session->spare_template = NULL;
+            template = load_template(session, spare, index);
+        }
+        if (!template) {
+            recycle_template(session, next);
+            return -1;
+        }
+        recycle_template(session, (board_t*)session->level_template);
+        session->level_template = template;
+        session->level_index = index;
+    }
+    recycle_template(session, next);
+    session->level_limit = levels->n_levels;
+
+    board_lock(&session->sync);
+    int result = install_level(session, points);
+    board_unlock(&session->sync);
+    return result;
+}
+
+void session_release(session_t* session) {
+    if (session->threads_running) {
+        stop_threads(session);
+    }
+    if (session->recorder) {
+        recorder_close(session->recorder);
+    }
+
+    if (session->req_pipe_fd >= 0) close(session->req_pipe_fd);
+    if (session->notif_pipe_fd >= 0) close(session->notif_pipe_fd);
+
+    board_t* board = (board_t*)session->board;
+    unload_level(board);
+    free(board);
+    board_t* templates[] = {session->level_template, session->next_template, session->spare_template};
+    for (int i = 0; i < 3; i++) {
+        if (templates[i]) {
+            unload_level(templates[i]);
+            free(templates[i]);
+        }
+    }
+    free(session->frame_buf);
+    destroy_game_sync(&session->sync);
+    free(session);
+}
@@ -1,5 +1,7 @@
 #include "threads.h"
 #include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
 
 /* Inicializa a estrutura de sincronização */
 int init_game_sync(game_sync_t* sync) {
@@ -20,12 +22,58 @@ int init_game_sync(game_sync_t* sync) {
         return -1;
     }
     
+    if (pthread_cond_init(&sync->start_cond, NULL) != 0) {
+        pthread_mutex_destroy(&sync->board_mutex);
+        pthread_cond_destroy(&sync->display_ready_cond);
+        pthread_cond_destroy(&sync->game_tick_cond);
+        return -1;
+    }
+    
+    if (pthread_cond_init(&sync->game_done_cond, NULL) != 0) {
+        pthread_mutex_destroy(&sync->board_mutex);
+        pthread_cond_destroy(&sync->display_ready_cond);
+        pthread_cond_destroy(&sync->game_tick_cond);
+        pthread_cond_destroy(&sync->start_cond);
+        return -1;
+    }
+    
+    if (tick_wake_init(&sync->ghost_wake) != 0) {
+        pthread_mutex_destroy(&sync->board_mutex);
+        pthread_cond_destroy(&sync->display_ready_cond);
+        pthread_cond_destroy(&sync->game_tick_cond);
+        pthread_cond_destroy(&sync->start_cond);
+        pthread_cond_destroy(&sync->game_done_cond);
+        return -1;
+    }
+    
+    if (pipe(sync->pacman_wake) != 0) {
+        pthread_mutex_destroy(&sync->board_mutex);
+        pthread_cond_destroy(&sync->display_ready_cond);
+        pthread_cond_destroy(&sync->game_tick_cond);
+        pthread_cond_destroy(&sync->start_cond);
+        pthread_cond_destroy(&sync->game_done_cond);
+        tick_wake_destroy(&sync->ghost_wake);
+        return -1;
+    }
+    for (int i = 0; i < 2; i++) {
+        fcntl(sync->pacman_wake[i], F_SETFL, fcntl(sync->pacman_wake[i], F_GETFL) | O_NONBLOCK);
+        fcntl(sync->pacman_wake[i], F_SETFD, FD_CLOEXEC);
+    }
+    
     // Inicializar flags
     sync->game_running = 1;
     sync->display_ready = 0;
     sync->level_complete = 0;
     sync->pacman_dead = 0;
     sync->quick_save_requested = 0;
+    sync->game_id = 0;
+    sync->closing = 0;
+    sync->playing = 0;
+    sync->next_game = -1;
+    sync->level_id = 0;
+#ifdef LOCK_PROFILING
+    lockprof_init(&sync->board_profile);
+#endif
     
     return 0;
 }
@@ -35,5 +83,125 @@ void destroy_game_sync(game_sync_t* sync) {
     pthread_mutex_destroy(&sync->board_mutex);
     pthread_cond_destroy(&sync->display_ready_cond);
     pthread_cond_destroy(&sync->game_tick_cond);
+    pthread_cond_destroy(&sync->start_cond);
+    pthread_cond_destroy(&sync->game_done_cond);
+    tick_wake_destroy(&sync->ghost_wake);
+    close(sync->pacman_wake[0]);
+    close(sync->pacman_wake[1]);
+}
+
+
+/* Inicializa o buffer circular produtor-consumidor */
+int init_connection_buffer(connection_buffer_t* buffer, int capacity) {
+    buffer->requests = malloc(capacity * sizeof(connection_request_t));
+    if (!buffer->requests) {
+        return -1;
+    }
+    buffer->head = 0;
+    buffer->tail = 0;
+    buffer->count = 0;
+    buffer->max_size = capacity;
+    pthread_mutex_init(&buffer->mutex, NULL);
+#ifdef LOCK_PROFILING
+    lockprof_init(&buffer->profile);
+#endif
+    sem_init(&buffer->empty, 0, capacity);  // Inicialmente todos vazios
+    sem_init(&buffer->full, 0, 0);          // Inicialmente nenhum cheio
+    return 0;
+}
+
+/* Destrói o buffer circular */
+void destroy_connection_buffer(connection_buffer_t* buffer) {
+    free(buffer->requests);
+    buffer->requests = NULL;
+    pthread_mutex_destroy(&buffer->mutex);
+    sem_destroy(&buffer->empty);
+    sem_destroy(&buffer->full);
+}
+
+/* Redimensiona o anel. Os slots vazios são representados por tokens no
+semáforo empty: crescer publica tokens novos, encolher só retira os tokens
+que ainda não foram reservados por um produtor. Chamar com buffer->mutex bloqueado. */
+static int resize_locked(connection_buffer_t* buffer, int new_capacity) {
+    int old_capacity = buffer->max_size;
+    if (new_capacity < buffer->count) {
+        new_capacity = buffer->count;
+    }
+
+    int removed = 0;
+    if (new_capacity < old_capacity) {
+        while (old_capacity - removed > new_capacity && sem_trywait(&buffer->empty) == 0) {
+            removed++;
+        }
+        new_capacity = old_capacity - removed;
+    }
+
+    if (new_capacity == old_capacity || new_capacity <= 0) {
+        return old_capacity;
+    }
+
+    connection_request_t* requests = malloc(new_capacity * sizeof(connection_request_t));
+    if (!requests) {
+        // Devolver os tokens reservados e manter o anel atual
+        for (int i = 0; i < removed; i++) {
+            sem_post(&buffer->empty);
+        }
+        return old_capacity;
+    }
+
+    // Linearizar os pedidos pendentes a partir de tail
+    for (int i = 0; i < buffer->count; i++) {
+        requests[i] = buffer->requests[(buffer->tail + i) % old_capacity];
+    }
+    free(buffer->requests);
+    buffer->requests = requests;
+    buffer->tail = 0;
+    buffer->head = buffer->count % new_capacity;
+    buffer->max_size = new_capacity;
+
+    for (int i = old_capacity; i < new_capacity; i++) {
+        sem_post(&buffer->empty);
+    }
+
+    return new_capacity;
 }
 
+void connection_buffer_stats(connection_buffer_t* buffer, int* count, int* capacity) {
+    prof_lock(&buffer->mutex, &buffer->profile);
+    if (count) *count = buffer->count;
+    if (capacity) *capacity = buffer->max_size;
+    prof_unlock(&buffer->mutex, &buffer->profile);
+}
+
+/* A decisão e o redimensionamento acontecem sob o mesmo lock, por isso
+crescer (anfitriã) e encolher (escalonador) nunca decidem sobre uma
+capacidade desatualizada. */
+int grow_connection_buffer(connection_buffer_t* buffer, int limit, int* old_capacity) {
+    prof_lock(&buffer->mutex, &buffer->profile);
+    int capacity = buffer->max_size;
+    int new_capacity = capacity;
+    if (capacity < limit) {
+        int target = capacity * 2;
+        if (target > limit) target = limit;
+        new_capacity = resize_locked(buffer, target);
+    }
+    prof_unlock(&buffer->mutex, &buffer->profile);
+
+    if (old_capacity) *old_capacity = capacity;
+    return new_capacity;
+}
+
+int shrink_connection_buffer(connection_buffer_t* buffer, int floor, int* old_capacity) {
+    prof_lock(&buffer->mutex, &buffer->profile);
+    int capacity = buffer->max_size;
+    int new_capacity = capacity;
+    if (capacity > floor && buffer->count <= capacity / 4) {
+        int target = capacity / 2;
+        if (target < floor) target = floor;
+        new_capacity = resize_locked(buffer, target);
+    }
+    prof_unlock(&buffer->mutex, &buffer->profile);
+
+    if (old_capacity) *old_capacity = capacity;
+    return new_capacity;
+}
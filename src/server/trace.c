@@ -0,0 +1,318 @@
+#include "trace.h"
+#include "log.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    uint64_t start;                    // ns desde trace_epoch
+    uint64_t duration;
+    const char* name;
+    int session;
+} trace_event_t;
+
+/* Anel de uma thread: só a própria escreve. O flush lê sem parar a escrita,
+como um seqlock: copia os eventos e volta a ler head para descartar os slots
+que possam ter sido sobrescritos durante a cópia. */
+typedef struct trace_ring {
+    trace_event_t events[TRACE_RING_EVENTS];
+    uint64_t head;                     // Eventos escritos desde o início
+    int tid;
+    int session;                       // Etiqueta dos próximos eventos
+    char name[32];
+    struct trace_ring* next;
+} trace_ring_t;
+
+static int trace_enabled = 0;          // Fixado em trace_init, antes de haver outras threads
+static char* trace_path = NULL;
+static uint64_t trace_epoch = 0;
+static pthread_key_t ring_key;
+static _Thread_local trace_ring_t* local_ring = NULL;
+
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static trace_ring_t* rings = NULL;     // Threads vivas
+static trace_ring_t* retired = NULL;   // Threads terminadas, mais antiga primeiro
+static int n_retired = 0;
+static int next_tid = 1;
+
+static trace_event_t snapshot[TRACE_RING_EVENTS];  // Cópia de um anel (flush com registry_mutex)
+
+static pthread_t signal_thread;
+static volatile int signal_running = 0;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// ========== ANÉIS ==========
+
+static void unlink_ring(trace_ring_t** list, trace_ring_t* ring) {
+    for (trace_ring_t** p = list; *p; p = &(*p)->next) {
+        if (*p == ring) {
+            *p = ring->next;
+            return;
+        }
+    }
+}
+
+/* Destrutor da thread: o anel fica para o próximo flush, até TRACE_MAX_RETIRED. */
+static void retire_ring(void* arg) {
+    trace_ring_t* ring = (trace_ring_t*)arg;
+
+    pthread_mutex_lock(&registry_mutex);
+    unlink_ring(&rings, ring);
+    ring->next = NULL;
+    trace_ring_t** tail = &retired;
+    while (*tail) tail = &(*tail)->next;
+    *tail = ring;
+    n_retired++;
+
+    trace_ring_t* dropped = NULL;
+    if (n_retired > TRACE_MAX_RETIRED) {
+        dropped = retired;
+        retired = dropped->next;
+        n_retired--;
+    }
+    pthread_mutex_unlock(&registry_mutex);
+    free(dropped);
+}
+
+static trace_ring_t* get_ring(void) {
+    if (local_ring) {
+        return local_ring;
+    }
+
+    trace_ring_t* ring = calloc(1, sizeof(trace_ring_t));
+    if (!ring) {
+        return NULL;
+    }
+    ring->session = -1;
+
+    pthread_mutex_lock(&registry_mutex);
+    ring->tid = next_tid++;
+    snprintf(ring->name, sizeof(ring->name), "thread %d", ring->tid);
+    ring->next = rings;
+    rings = ring;
+    pthread_mutex_unlock(&registry_mutex);
+
+    pthread_setspecific(ring_key, ring);
+    local_ring = ring;
+    return ring;
+}
+
+void trace_thread(const char* name, int session) {
+    if (!trace_enabled) return;
+    trace_ring_t* ring = get_ring();
+    if (!ring) return;
+
+    // O nome é lido pelo flush, por isso muda com o registo bloqueado
+    pthread_mutex_lock(&registry_mutex);
+    if (session >= 0) {
+        snprintf(ring->name, sizeof(ring->name), "%s (client %d)", name, session);
+    } else {
+        snprintf(ring->name, sizeof(ring->name), "%s", name);
+    }
+    pthread_mutex_unlock(&registry_mutex);
+    ring->session = session;
+}
+
+void trace_set_session(int session) {
+    if (!trace_enabled) return;
+    trace_ring_t* ring = get_ring();
+    if (ring) ring->session = session;
+}
+
+uint64_t trace_begin(void) {
+    if (!trace_enabled) return 0;
+    return monotonic_ns();
+}
+
+void trace_end(const char* name, uint64_t start) {
+    if (!trace_enabled) return;
+    trace_ring_t* ring = get_ring();
+    if (!ring) return;
+
+    uint64_t head = ring->head;
+    trace_event_t* event = &ring->events[head % TRACE_RING_EVENTS];
+    uint64_t duration = monotonic_ns() - start;
+
+    // O head anterior fica visível antes de o slot mudar: o flush deteta a sobrescrita
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&event->start, start - trace_epoch, __ATOMIC_RELAXED);
+    __atomic_store_n(&event->duration, duration, __ATOMIC_RELAXED);
+    __atomic_store_n(&event->name, name, __ATOMIC_RELAXED);
+    __atomic_store_n(&event->session, ring->session, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// ========== EXPORTAÇÃO ==========
+
+/* Copia para snapshot os eventos que a escrita concorrente não pode ter
+estragado e devolve o primeiro válido; os eventos vão até *head. */
+static uint64_t copy_ring(trace_ring_t* ring, uint64_t* head) {
+    uint64_t end = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint64_t from = end > TRACE_RING_EVENTS ? end - TRACE_RING_EVENTS : 0;
+    for (uint64_t i = from; i < end; i++) {
+        trace_event_t* event = &ring->events[i % TRACE_RING_EVENTS];
+        trace_event_t* copy = &snapshot[i % TRACE_RING_EVENTS];
+        copy->start = __atomic_load_n(&event->start, __ATOMIC_RELAXED);
+        copy->duration = __atomic_load_n(&event->duration, __ATOMIC_RELAXED);
+        copy->name = __atomic_load_n(&event->name, __ATOMIC_RELAXED);
+        copy->session = __atomic_load_n(&event->session, __ATOMIC_RELAXED);
+    }
+
+    // Com head = h, o escritor pode estar no slot do evento h - TRACE_RING_EVENTS
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint64_t now = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    if (now >= TRACE_RING_EVENTS && now - TRACE_RING_EVENTS + 1 > from) {
+        from = now - TRACE_RING_EVENTS + 1;
+    }
+    *head = end;
+    return from < end ? from : end;
+}
+
+static void write_ring(FILE* out, trace_ring_t* ring, int* first) {
+    fprintf(out, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                 "\"args\":{\"name\":\"%s\"}}", *first ? "" : ",", ring->tid, ring->name);
+    *first = 0;
+
+    uint64_t head;
+    uint64_t from = copy_ring(ring, &head);
+    for (uint64_t i = from; i < head; i++) {
+        trace_event_t* event = &snapshot[i % TRACE_RING_EVENTS];
+        fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"server\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                     "\"ts\":%.3f,\"dur\":%.3f",
+                event->name, ring->tid, event->start / 1000.0, event->duration / 1000.0);
+        if (event->session >= 0) {
+            fprintf(out, ",\"args\":{\"session\":%d}", event->session);
+        }
+        fputc('}', out);
+    }
+}
+
+int trace_flush(void) {
+    if (!trace_enabled) return 0;
+
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", trace_path);
+    FILE* out = fopen(tmp_path, "w");
+    if (!out) {
+        perror("Failed to create trace file");
+        return -1;
+    }
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    int first = 1;
+    pthread_mutex_lock(&registry_mutex);
+    for (trace_ring_t* ring = retired; ring; ring = ring->next) {
+        write_ring(out, ring, &first);
+    }
+    for (trace_ring_t* ring = rings; ring; ring = ring->next) {
+        write_ring(out, ring, &first);
+    }
+    pthread_mutex_unlock(&registry_mutex);
+    fprintf(out, "\n]}\n");
+
+    if (fclose(out) != 0 || rename(tmp_path, trace_path) != 0) {
+        perror("Failed to write trace file");
+        return -1;
+    }
+    log_info("Trace: written to %s\n", trace_path);
+    return 0;
+}
+
+// ========== SINAIS ==========
+
+static void trace_signal_set(sigset_t* set) {
+    sigemptyset(set);
+    sigaddset(set, SIGUSR2);
+    sigaddset(set, SIGINT);
+    sigaddset(set, SIGTERM);
+}
+
+void trace_add_signals(sigset_t* set) {
+    const char* path = getenv(TRACE_PATH_ENV);
+    if (path && *path) {
+        sigaddset(set, SIGUSR2);
+        sigaddset(set, SIGINT);
+        sigaddset(set, SIGTERM);
+    }
+}
+
+/* Única thread com SIGUSR2/SIGINT/SIGTERM desbloqueados (via sigwait). */
+static void* signal_thread_func(void* arg) {
+    (void)arg;
+    sigset_t set;
+    trace_signal_set(&set);
+
+    while (signal_running) {
+        int sig;
+        if (sigwait(&set, &sig) != 0) {
+            continue;
+        }
+        if (!signal_running) {
+            break;
+        }
+        trace_flush();
+
+        if (sig != SIGUSR2) {
+            // Terminar como o sinal terminaria sem tracing
+            signal(sig, SIG_DFL);
+            sigset_t only;
+            sigemptyset(&only);
+            sigaddset(&only, sig);
+            pthread_sigmask(SIG_UNBLOCK, &only, NULL);
+            raise(sig);
+        }
+    }
+    return NULL;
+}
+
+// ========== CICLO DE VIDA ==========
+
+int trace_init(void) {
+    const char* path = getenv(TRACE_PATH_ENV);
+    if (!path || !*path) {
+        return 0;
+    }
+
+    if (pthread_key_create(&ring_key, retire_ring) != 0) {
+        return -1;
+    }
+    trace_path = strdup(path);
+    trace_epoch = monotonic_ns();
+    trace_enabled = 1;
+
+    // Já bloqueados pelo main; repetido para quem chame trace_init sem essa máscara
+    sigset_t set;
+    trace_signal_set(&set);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    signal_running = 1;
+    if (pthread_create(&signal_thread, NULL, signal_thread_func, NULL) != 0) {
+        signal_running = 0;
+        return -1;
+    }
+
+    trace_thread("main", -1);
+    log_info("Trace: enabled, SIGUSR2 writes %s\n", trace_path);
+    return 0;
+}
+
+void trace_shutdown(void) {
+    if (!trace_enabled) {
+        return;
+    }
+
+    if (signal_running) {
+        signal_running = 0;
+        pthread_kill(signal_thread, SIGUSR2);
+        pthread_join(signal_thread, NULL);
+    }
+    trace_flush();
+}
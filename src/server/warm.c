@@ -0,0 +1,196 @@
+#include "warm.h"
+#include "log.h"
+#include "session.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <signal.h>
+
+// ========== LISTA DE NÍVEIS ==========
+
+// Nomes só com dígitos comparam pelo valor (2 antes de 10), os outros por strcmp
+static int compare_level_names(const void* a, const void* b) {
+    const char* name1 = (const char*)a;
+    const char* name2 = (const char*)b;
+
+    int is_num1 = *name1 != '\0';
+    for (int i = 0; name1[i] != '\0' && is_num1; i++) {
+        is_num1 = isdigit((unsigned char)name1[i]);
+    }
+    int is_num2 = *name2 != '\0';
+    for (int i = 0; name2[i] != '\0' && is_num2; i++) {
+        is_num2 = isdigit((unsigned char)name2[i]);
+    }
+
+    if (is_num1 && is_num2) {
+        return atoi(name1) - atoi(name2);
+    }
+    return strcmp(name1, name2);
+}
+
+/* Lista os .lvl do diretório, ordena-os e parseia-os. Devolve o número de
+níveis carregados. */
+static int load_level_list(level_list_t* levels, char* levels_directory) {
+    levels->directory = levels_directory;
+
+    DIR* dir = opendir(levels_directory);
+    if (!dir) {
+        perror("Failed to open levels directory");
+        return 0;
+    }
+
+    char names[MAX_LEVELS][MAX_FILENAME];
+    int n_names = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL && n_names < MAX_LEVELS) {
+        if (strstr(entry->d_name, ".lvl")) {
+            // Remover extensão .lvl do nome
+            char* name = names[n_names];
+            strncpy(name, entry->d_name, MAX_FILENAME - 1);
+            name[MAX_FILENAME - 1] = '\0';
+            char* ext = strstr(name, ".lvl");
+            if (ext) *ext = '\0';
+            n_names++;
+        }
+    }
+    closedir(dir);
+    qsort(names, n_names, MAX_FILENAME, compare_level_names);
+
+    levels->levels = calloc(n_names > 0 ? n_names : 1, sizeof(level_data_t));
+    if (!levels->levels) {
+        return 0;
+    }
+    for (int i = 0; i < n_names; i++) {
+        if (parse_level_file(levels_directory, names[i], &levels->levels[levels->n_levels]) != 0) {
+            log_warn("Warm pool: Failed to parse level %s, skipping it\n", names[i]);
+            continue;
+        }
+        levels->n_levels++;
+    }
+    return levels->n_levels;
+}
+
+// ========== THREAD DE REPOSIÇÃO ==========
+
+static void* refill_thread_func(void* arg) {
+    warm_pool_t* warm = (warm_pool_t*)arg;
+
+    // As threads das sessões herdam esta máscara
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+    trace_thread("warm refill", -1);
+
+    while (1) {
+        pthread_mutex_lock(&warm->mutex);
+        while (warm->running && warm->n_ready >= WARM_POOL_SIZE) {
+            pthread_cond_wait(&warm->refill_cond, &warm->mutex);
+        }
+        if (!warm->running) {
+            pthread_mutex_unlock(&warm->mutex);
+            break;
+        }
+        pthread_mutex_unlock(&warm->mutex);
+
+        // Construir fora do lock: parsing e criação de threads são lentos
+        session_t* session = session_prepare(&warm->levels);
+        if (!session) {
+            log_warn("Warm pool: failed to prepare session for level %s\n", warm->levels.levels[0].level_name);
+            sleep_ms(1000);
+            continue;
+        }
+
+        pthread_mutex_lock(&warm->mutex);
+        if (warm->running && warm->n_ready < WARM_POOL_SIZE) {
+            warm->ready[warm->n_ready++] = session;
+            session = NULL;
+        }
+        pthread_mutex_unlock(&warm->mutex);
+
+        if (session) {
+            session_release(session);
+        }
+    }
+
+    return NULL;
+}
+
+// ========== API ==========
+
+int warm_pool_init(warm_pool_t* warm, char* levels_directory) {
+    memset(warm, 0, sizeof(*warm));
+
+    // Listar e parsear os níveis uma única vez (antes era feito a cada CONNECT)
+    if (load_level_list(&warm->levels, levels_directory) == 0) {
+        log_error("Warm pool: No loadable levels in %s\n", levels_directory);
+        free(warm->levels.levels);
+        return -1;
+    }
+
+    warm->running = 1;
+    pthread_mutex_init(&warm->mutex, NULL);
+    pthread_cond_init(&warm->refill_cond, NULL);
+    pthread_create(&warm->refill_thread, NULL, refill_thread_func, warm);
+
+    log_info("Warm pool: %d levels (%s first), keeping %d sessions ready\n",
+          warm->levels.n_levels, warm->levels.levels[0].level_name, WARM_POOL_SIZE);
+    return 0;
+}
+
+void warm_pool_destroy(warm_pool_t* warm) {
+    pthread_mutex_lock(&warm->mutex);
+    warm->running = 0;
+    pthread_cond_broadcast(&warm->refill_cond);
+    pthread_mutex_unlock(&warm->mutex);
+
+    pthread_join(warm->refill_thread, NULL);
+
+    for (int i = 0; i < warm->n_ready; i++) {
+        session_release(warm->ready[i]);
+    }
+    warm->n_ready = 0;
+    free(warm->levels.levels);
+
+    pthread_mutex_destroy(&warm->mutex);
+    pthread_cond_destroy(&warm->refill_cond);
+}
+
+session_t* warm_pool_acquire(warm_pool_t* warm) {
+    session_t* session = NULL;
+
+    pthread_mutex_lock(&warm->mutex);
+    if (warm->n_ready > 0) {
+        session = warm->ready[--warm->n_ready];
+    }
+    pthread_cond_signal(&warm->refill_cond);
+    pthread_mutex_unlock(&warm->mutex);
+
+    if (!session) {
+        // Pool vazio (pico de ligações): construir já, como antes
+        log_debug("Warm pool: empty, preparing session synchronously\n");
+        session = session_prepare(&warm->levels);
+    }
+
+    return session;
+}
+
+void warm_pool_return(warm_pool_t* warm, session_t* session) {
+    session->req_pipe_path[0] = '\0';
+    session->notif_pipe_path[0] = '\0';
+    session->active = 0;
+
+    pthread_mutex_lock(&warm->mutex);
+    if (warm->running && warm->n_ready < WARM_POOL_SIZE) {
+        warm->ready[warm->n_ready++] = session;
+        session = NULL;
+    }
+    pthread_mutex_unlock(&warm->mutex);
+
+    if (session) {
+        session_release(session);
+    }
+}
@@ -0,0 +1,458 @@
+#include "board.h"
+#include "frame.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_REPEATS 5                // Medições por caso (reporta-se a mediana)
+#define BENCH_MAX_SIZES 16
+#define BENCH_MAX_GHOST_COUNTS 16
+#define BENCH_MAX_BASELINE 1024
+#define LEVEL_FILE_LIMIT 4096          // parse_*_file lê no máximo 4095 bytes
+
+// Caso de benchmark: board sintético e estado auxiliar
+typedef struct {
+    board_t board;
+    char* frame_buf;
+    char tmp_dir[64];
+    char level_name[32];
+    int level_width;                   // Dimensões efetivas do .lvl gerado
+    int level_height;
+} bench_ctx_t;
+
+typedef void (*bench_fn_t)(bench_ctx_t* ctx, long iterations);
+
+typedef struct {
+    char bench[64];
+    int width, height, ghosts;
+    double ns_per_op;
+} baseline_entry_t;
+
+static baseline_entry_t baseline[BENCH_MAX_BASELINE];
+static int n_baseline = 0;
+static double threshold_pct = 10.0;
+static int regressions = 0;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// ========== BOARD SINTÉTICO ==========
+
+/* Board com paredes no perímetro e pontos no interior. O pacman fica em (1,1)
+e os ghosts em linhas a partir de y = 3, de 3 em 3 colunas, com um script D/A.
+Devolve o número de ghosts colocados (limitado pelo espaço disponível). */
+static int build_board(board_t* board, int width, int height, int n_ghosts) {
+    memset(board, 0, sizeof(*board));
+    board->width = width;
+    board->height = height;
+    board->tempo = 100;
+    board->board = calloc((size_t)width * height, sizeof(board_pos_t));
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            board_pos_t* cell = &board->board[y * width + x];
+            if (x == 0 || y == 0 || x == width - 1 || y == height - 1) {
+                cell->content = 'W';
+            } else {
+                cell->content = ' ';
+                cell->has_dot = 1;
+            }
+        }
+    }
+
+    board->n_pacmans = 1;
+    board->pacmans = calloc(1, sizeof(pacman_t));
+    pacman_t* pac = &board->pacmans[0];
+    pac->pos_x = 1;
+    pac->pos_y = 1;
+    pac->alive = 1;
+    board->board[width + 1].content = 'P';
+
+    int capacity = ((height - 4) > 0 ? (height - 4) : 0) * ((width - 3) / 3);
+    if (n_ghosts > capacity) n_ghosts = capacity;
+    board->n_ghosts = n_ghosts;
+    board->ghosts = calloc(n_ghosts > 0 ? n_ghosts : 1, sizeof(ghost_t));
+
+    int per_row = (width - 3) / 3;
+    for (int g = 0; g < n_ghosts; g++) {
+        ghost_t* ghost = &board->ghosts[g];
+        ghost->pos_x = 2 + 3 * (g % per_row);
+        ghost->pos_y = 3 + g / per_row;
+        ghost->n_moves = 2;
+        ghost->moves[0] = (command_t){.command = 'D', .turns = 1, .turns_left = 1};
+        ghost->moves[1] = (command_t){.command = 'A', .turns = 1, .turns_left = 1};
+        board->board[ghost->pos_y * width + ghost->pos_x].content = 'M';
+    }
+
+    rng_seed(&board->rng, 1);
+    return n_ghosts;
+}
+
+/* Escreve um .lvl, .p e .m sintéticos limitados ao que o parser aceita. */
+static int write_level_files(bench_ctx_t* ctx, int width, int height, int n_ghosts) {
+    strcpy(ctx->tmp_dir, "/tmp/pacman-bench-XXXXXX");
+    if (!mkdtemp(ctx->tmp_dir)) {
+        return -1;
+    }
+    strcpy(ctx->level_name, "bench");
+
+    // Linhas até MAX_FILENAME - 1, até MAX_BOARD_HEIGHT linhas e ficheiro < LEVEL_FILE_LIMIT
+    if (width > MAX_FILENAME - 2) width = MAX_FILENAME - 2;
+    if (height > MAX_BOARD_HEIGHT) height = MAX_BOARD_HEIGHT;
+    if (n_ghosts > MAX_GHOSTS) n_ghosts = MAX_GHOSTS;
+    int header = 64 + n_ghosts * 8;
+    while (height > 3 && header + (width + 1) * height >= LEVEL_FILE_LIMIT) {
+        height--;
+    }
+    while (width > 3 && header + (width + 1) * height >= LEVEL_FILE_LIMIT) {
+        width--;
+    }
+    ctx->level_width = width;
+    ctx->level_height = height;
+
+    char path[128];
+    snprintf(path, sizeof(path), "%s/bench.lvl", ctx->tmp_dir);
+    FILE* f = fopen(path, "w");
+    if (!f) return -1;
+    fprintf(f, "DIM %d %d\nTEMPO 100\nPAC bench.p\nMON", width, height);
+    for (int g = 0; g < n_ghosts; g++) fprintf(f, " bench.m");
+    fprintf(f, "\n");
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int edge = x == 0 || y == 0 || x == width - 1 || y == height - 1;
+            fputc(edge ? 'X' : (x == 1 && y == 1) ? 'P' : 'o', f);
+        }
+        fputc('\n', f);
+    }
+    fclose(f);
+
+    snprintf(path, sizeof(path), "%s/bench.p", ctx->tmp_dir);
+    f = fopen(path, "w");
+    if (!f) return -1;
+    fprintf(f, "PASSO 0\nPOS 1 1\n");
+    fclose(f);
+
+    snprintf(path, sizeof(path), "%s/bench.m", ctx->tmp_dir);
+    f = fopen(path, "w");
+    if (!f) return -1;
+    fprintf(f, "# Ghost sintético\nPASSO 1\nPOS 1 2\n");
+    for (int m = 0; m < MAX_MOVES; m++) {
+        fprintf(f, "%c %d\n", "WASDCTR"[m % 7], 1 + m % 3);
+    }
+    fclose(f);
+    return 0;
+}
+
+static void remove_level_files(bench_ctx_t* ctx) {
+    const char* files[] = {"bench.lvl", "bench.p", "bench.m"};
+    char path[128];
+    for (int i = 0; i < 3; i++) {
+        snprintf(path, sizeof(path), "%s/%s", ctx->tmp_dir, files[i]);
+        unlink(path);
+    }
+    rmdir(ctx->tmp_dir);
+}
+
+// ========== BENCHMARKS ==========
+
+// Uma jogada do pacman, alternando D e A
+static void bench_move_pacman(bench_ctx_t* ctx, long iterations) {
+    command_t cmd = {.command = 'D', .turns = 1, .turns_left = 1};
+    for (long i = 0; i < iterations; i++) {
+        cmd.command = (i & 1) ? 'A' : 'D';
+        cmd.turns_left = 1;
+        move_pacman(&ctx->board, 0, &cmd);
+    }
+}
+
+// Um tick completo: todos os ghosts executam o comando atual
+static void bench_move_ghost(bench_ctx_t* ctx, long iterations) {
+    board_t* board = &ctx->board;
+    for (long i = 0; i < iterations; i++) {
+        for (int g = 0; g < board->n_ghosts; g++) {
+            ghost_t* ghost = &board->ghosts[g];
+            move_ghost(board, g, &ghost->moves[ghost->current_move % ghost->n_moves]);
+        }
+    }
+}
+
+// Todos os ghosts fazem uma investida até ao próximo obstáculo, alternando D e A
+static void bench_move_ghost_charged(bench_ctx_t* ctx, long iterations) {
+    board_t* board = &ctx->board;
+    for (long i = 0; i < iterations; i++) {
+        char direction = (i & 1) ? 'A' : 'D';
+        for (int g = 0; g < board->n_ghosts; g++) {
+            move_ghost_charged(board, g, direction);
+        }
+    }
+}
+
+/* find_and_kill_pacman é privada de board.c: mede-se através de move_ghost
+para a casa do pacman, repondo o estado a cada iteração. */
+static void bench_kill_pacman(bench_ctx_t* ctx, long iterations) {
+    board_t* board = &ctx->board;
+    pacman_t* pac = &board->pacmans[0];
+    ghost_t* ghost = &board->ghosts[0];
+    int pac_index = pac->pos_y * board->width + pac->pos_x;
+    int ghost_x = pac->pos_x + 1, ghost_y = pac->pos_y;
+    command_t cmd = {.command = 'A', .turns = 1, .turns_left = 1};
+
+    for (long i = 0; i < iterations; i++) {
+        ghost->pos_x = ghost_x;
+        ghost->pos_y = ghost_y;
+        ghost->waiting = 0;
+        board->board[ghost_y * board->width + ghost_x].content = 'M';
+        board->board[pac_index].content = 'P';
+        pac->alive = 1;
+        cmd.turns_left = 1;
+        move_ghost(board, 0, &cmd);
+    }
+}
+
+static void bench_parse_level_file(bench_ctx_t* ctx, long iterations) {
+    level_data_t* level = malloc(sizeof(level_data_t));
+    for (long i = 0; i < iterations; i++) {
+        parse_level_file(ctx->tmp_dir, ctx->level_name, level);
+    }
+    free(level);
+}
+
+static void bench_parse_monster_file(bench_ctx_t* ctx, long iterations) {
+    ghost_t ghost;
+    for (long i = 0; i < iterations; i++) {
+        parse_monster_file(ctx->tmp_dir, "bench.m", &ghost);
+    }
+}
+
+static void bench_encode_board_frame(bench_ctx_t* ctx, long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        encode_board_frame(&ctx->board, 0, 0, ctx->frame_buf);
+    }
+}
+
+// ========== MEDIÇÃO ==========
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Calibra o número de iterações para ~target_ns e devolve a mediana de ns/op. */
+static double measure(bench_fn_t fn, bench_ctx_t* ctx, long long target_ns, long* iterations_out) {
+    long iterations = 1;
+    while (1) {
+        long long start = now_ns();
+        fn(ctx, iterations);
+        long long elapsed = now_ns() - start;
+        if (elapsed >= target_ns / 10 || iterations >= (1L << 40)) {
+            double per_op = (double)elapsed / iterations;
+            if (per_op < 0.1) per_op = 0.1;
+            long wanted = (long)(target_ns / per_op);
+            iterations = wanted > 0 ? wanted : 1;
+            break;
+        }
+        iterations *= 2;
+    }
+
+    double samples[BENCH_REPEATS];
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        long long start = now_ns();
+        fn(ctx, iterations);
+        samples[r] = (double)(now_ns() - start) / iterations;
+    }
+    qsort(samples, BENCH_REPEATS, sizeof(double), compare_double);
+    *iterations_out = iterations;
+    return samples[BENCH_REPEATS / 2];
+}
+
+static baseline_entry_t* find_baseline(const char* bench, int width, int height, int ghosts) {
+    for (int i = 0; i < n_baseline; i++) {
+        if (strcmp(baseline[i].bench, bench) == 0 && baseline[i].width == width &&
+            baseline[i].height == height && baseline[i].ghosts == ghosts) {
+            return &baseline[i];
+        }
+    }
+    return NULL;
+}
+
+static void report(const char* bench, int width, int height, int ghosts, long iterations,
+                   double ns_per_op) {
+    printf("{\"bench\":\"%s\",\"width\":%d,\"height\":%d,\"ghosts\":%d,\"iterations\":%ld,"
+           "\"ns_per_op\":%.2f,\"ops_per_sec\":%.0f",
+           bench, width, height, ghosts, iterations, ns_per_op, 1e9 / ns_per_op);
+
+    baseline_entry_t* base = find_baseline(bench, width, height, ghosts);
+    if (base && base->ns_per_op > 0) {
+        double change = (ns_per_op - base->ns_per_op) / base->ns_per_op * 100.0;
+        int regressed = change > threshold_pct;
+        if (regressed) regressions++;
+        printf(",\"baseline_ns_per_op\":%.2f,\"change_pct\":%.1f,\"regression\":%s",
+               base->ns_per_op, change, regressed ? "true" : "false");
+    }
+    printf("}\n");
+    fflush(stdout);
+}
+
+static int load_baseline(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror("bench: baseline");
+        return -1;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), f) && n_baseline < BENCH_MAX_BASELINE) {
+        baseline_entry_t* entry = &baseline[n_baseline];
+        long iterations;
+        if (sscanf(line, "{\"bench\":\"%63[^\"]\",\"width\":%d,\"height\":%d,\"ghosts\":%d,"
+                         "\"iterations\":%ld,\"ns_per_op\":%lf",
+                   entry->bench, &entry->width, &entry->height, &entry->ghosts,
+                   &iterations, &entry->ns_per_op) == 6) {
+            n_baseline++;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+// ========== MAIN ==========
+
+static int selected(const char* filter, const char* bench) {
+    return !filter || strstr(bench, filter) != NULL;
+}
+
+/* Corre os benchmarks de board.c e frame.c para um tamanho e número de ghosts. */
+static void run_case(int width, int height, int n_ghosts, long long target_ns, const char* filter) {
+    bench_ctx_t ctx;
+    long iterations;
+    double ns;
+
+    static const struct {
+        const char* name;
+        bench_fn_t fn;
+        int needs_ghosts;
+    } board_benches[] = {
+        {"move_pacman", bench_move_pacman, 0},
+        {"move_ghost", bench_move_ghost, 1},
+        {"move_ghost_charged", bench_move_ghost_charged, 1},
+        {"find_and_kill_pacman", bench_kill_pacman, 1},
+        {"encode_board_frame", bench_encode_board_frame, 0},
+    };
+
+    for (size_t b = 0; b < sizeof(board_benches) / sizeof(board_benches[0]); b++) {
+        if (!selected(filter, board_benches[b].name)) continue;
+
+        // Board novo por benchmark: nenhum herda o estado deixado pelo anterior
+        int ghosts = build_board(&ctx.board, width, height, n_ghosts);
+        if (board_benches[b].needs_ghosts && ghosts == 0) {
+            unload_level(&ctx.board);
+            continue;
+        }
+        ctx.frame_buf = malloc(frame_size(&ctx.board));
+
+        ns = measure(board_benches[b].fn, &ctx, target_ns, &iterations);
+        report(board_benches[b].name, width, height, ghosts, iterations, ns);
+
+        free(ctx.frame_buf);
+        unload_level(&ctx.board);
+    }
+
+    if (!selected(filter, "parse_level_file") && !selected(filter, "parse_monster_file")) {
+        return;
+    }
+    if (write_level_files(&ctx, width, height, n_ghosts) != 0) {
+        perror("bench: level files");
+        return;
+    }
+    int level_ghosts = n_ghosts > MAX_GHOSTS ? MAX_GHOSTS : n_ghosts;
+    if (selected(filter, "parse_level_file")) {
+        ns = measure(bench_parse_level_file, &ctx, target_ns, &iterations);
+        report("parse_level_file", ctx.level_width, ctx.level_height, level_ghosts, iterations, ns);
+    }
+    if (selected(filter, "parse_monster_file")) {
+        ns = measure(bench_parse_monster_file, &ctx, target_ns, &iterations);
+        report("parse_monster_file", ctx.level_width, ctx.level_height, level_ghosts, iterations, ns);
+    }
+    remove_level_files(&ctx);
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [-s WxH]... [-g ghosts]... [-t ms] [-f filter] [-c baseline.jsonl] [-T pct]\n", program);
+    fprintf(stderr, "  -s WxH       board size (repeatable, default 10x10 100x100 1000x1000)\n");
+    fprintf(stderr, "  -g ghosts    ghost count (repeatable, default 1 25)\n");
+    fprintf(stderr, "  -t ms        measuring time per repeat (default 50)\n");
+    fprintf(stderr, "  -f filter    only benchmarks whose name contains filter\n");
+    fprintf(stderr, "  -c file      compare against a saved run (JSON lines from a previous run)\n");
+    fprintf(stderr, "  -T pct       slowdown counted as a regression with -c (default 10)\n");
+    fprintf(stderr, "Output: one JSON object per line on stdout.\n");
+}
+
+int main(int argc, char* argv[]) {
+    int widths[BENCH_MAX_SIZES], heights[BENCH_MAX_SIZES], n_sizes = 0;
+    int ghost_counts[BENCH_MAX_GHOST_COUNTS], n_ghost_counts = 0;
+    long long target_ns = 50 * 1000000LL;
+    const char* filter = NULL;
+    const char* baseline_path = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:g:t:f:c:T:")) != -1) {
+        switch (opt) {
+            case 's':
+                if (n_sizes == BENCH_MAX_SIZES ||
+                    sscanf(optarg, "%dx%d", &widths[n_sizes], &heights[n_sizes]) != 2 ||
+                    widths[n_sizes] < 4 || heights[n_sizes] < 4) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                n_sizes++;
+                break;
+            case 'g':
+                if (n_ghost_counts == BENCH_MAX_GHOST_COUNTS) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                ghost_counts[n_ghost_counts++] = atoi(optarg);
+                break;
+            case 't': target_ns = atoll(optarg) * 1000000LL; break;
+            case 'f': filter = optarg; break;
+            case 'c': baseline_path = optarg; break;
+            case 'T': threshold_pct = atof(optarg); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind != argc || target_ns <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (n_sizes == 0) {
+        int defaults[] = {10, 100, 1000};
+        for (int i = 0; i < 3; i++) {
+            widths[n_sizes] = heights[n_sizes] = defaults[i];
+            n_sizes++;
+        }
+    }
+    if (n_ghost_counts == 0) {
+        ghost_counts[n_ghost_counts++] = 1;
+        ghost_counts[n_ghost_counts++] = 25;
+    }
+    if (baseline_path && load_baseline(baseline_path) != 0) {
+        return 1;
+    }
+
+    for (int s = 0; s < n_sizes; s++) {
+        for (int g = 0; g < n_ghost_counts; g++) {
+            run_case(widths[s], heights[s], ghost_counts[g], target_ns, filter);
+        }
+    }
+
+    if (baseline_path) {
+        fprintf(stderr, "bench: %d regression(s) above %.1f%% against %s\n",
+                regressions, threshold_pct, baseline_path);
+    }
+    return regressions ? 2 : 0;
+}
@@ -0,0 +1,317 @@
+#include "board.h"
+#include "rng.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LEVEL_FILE_LIMIT 4096          // parse_*_file lê no máximo 4095 bytes
+#define LEVEL_NAME_LIMIT 31            // level_data_t.level_name[32]
+#define MAX_TURNS 3                    // Repetições máximas de um comando gerado
+
+typedef struct {
+    const char* out_dir;
+    const char* name;
+    int width, height;
+    double wall_density;
+    int ghosts;
+    int script_length;
+    double charge_frequency;
+    int max_passo;
+    int tempo;
+    uint64_t seed;
+    int force;                         // 1 = ignorar os limites do parser
+} levelgen_config_t;
+
+/* Tamanho do .lvl gerado: cabeçalho (DIM, TEMPO, PAC, MON) mais width + 1 bytes por linha. */
+static long level_file_size(levelgen_config_t* c) {
+    long header = 64 + (long)strlen(c->name) * 2 + (long)c->ghosts * ((long)strlen(c->name) + 10);
+    return header + (long)(c->width + 1) * c->height;
+}
+
+static void clamp_int(const char* what, int* value, int limit) {
+    if (*value > limit) {
+        fprintf(stderr, "levelgen: %s %d exceeds the parser limit, using %d (-f to keep it)\n",
+                what, *value, limit);
+        *value = limit;
+    }
+}
+
+/* Ajusta a configuração aos limites de board.c: linhas de MAX_FILENAME - 1
+caracteres, MAX_BOARD_HEIGHT linhas, MAX_GHOSTS ghosts, MAX_MOVES comandos e
+ficheiros com menos de LEVEL_FILE_LIMIT bytes. */
+static void apply_parser_limits(levelgen_config_t* c) {
+    clamp_int("width", &c->width, MAX_FILENAME - 1);
+    clamp_int("height", &c->height, MAX_BOARD_HEIGHT);
+    clamp_int("ghost count", &c->ghosts, MAX_GHOSTS);
+    clamp_int("script length", &c->script_length, MAX_MOVES);
+
+    if (level_file_size(c) >= LEVEL_FILE_LIMIT) {
+        int width = c->width, height = c->height;
+        // Encolher a maior dimensão até o ficheiro caber
+        while (level_file_size(c) >= LEVEL_FILE_LIMIT && (c->width > 4 || c->height > 4)) {
+            if (c->width >= c->height && c->width > 4) c->width--;
+            else c->height--;
+        }
+        fprintf(stderr, "levelgen: %dx%d does not fit in %d bytes, using %dx%d (-f to keep it)\n",
+                width, height, LEVEL_FILE_LIMIT, c->width, c->height);
+    }
+}
+
+// ========== TABULEIRO ==========
+
+/* Paredes aleatórias no interior; depois fecha-se tudo o que não é alcançável
+a partir de start, para que pacman, ghosts e portal fiquem na mesma região. */
+static int build_grid(char* grid, levelgen_config_t* c, rng_t* rng, int* start) {
+    int w = c->width, h = c->height;
+    int free_cells = 0;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            int edge = x == 0 || y == 0 || x == w - 1 || y == h - 1;
+            int wall = edge || (rng_next(rng) / 4294967296.0) < c->wall_density;
+            grid[y * w + x] = wall ? 'X' : 'o';
+            if (!wall) free_cells++;
+        }
+    }
+    if (free_cells == 0) {
+        return 0;
+    }
+
+    // Início: uma casa livre ao acaso
+    int pick = (int)rng_bounded(rng, free_cells);
+    for (int i = 0; i < w * h; i++) {
+        if (grid[i] == 'o' && pick-- == 0) {
+            *start = i;
+            break;
+        }
+    }
+
+    int* queue = malloc((size_t)w * h * sizeof(int));
+    char* seen = calloc((size_t)w * h, 1);
+    int head = 0, tail = 0, reachable = 0;
+    queue[tail++] = *start;
+    seen[*start] = 1;
+    while (head < tail) {
+        int i = queue[head++];
+        reachable++;
+        int x = i % w, y = i / w;
+        int next[4] = {i - w, i + w, i - 1, i + 1};
+        int valid[4] = {y > 0, y < h - 1, x > 0, x < w - 1};
+        for (int d = 0; d < 4; d++) {
+            if (valid[d] && !seen[next[d]] && grid[next[d]] == 'o') {
+                seen[next[d]] = 1;
+                queue[tail++] = next[d];
+            }
+        }
+    }
+    for (int i = 0; i < w * h; i++) {
+        if (grid[i] == 'o' && !seen[i]) grid[i] = 'X';
+    }
+
+    free(queue);
+    free(seen);
+    return reachable;
+}
+
+/* Escolhe uma casa livre e ainda não usada; marca-a em used. */
+static int pick_free_cell(char* grid, char* used, int n_cells, int n_free, rng_t* rng) {
+    int pick = (int)rng_bounded(rng, n_free);
+    for (int i = 0; i < n_cells; i++) {
+        if (grid[i] == 'o' && !used[i] && pick-- == 0) {
+            used[i] = 1;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// ========== FICHEIROS ==========
+
+static FILE* open_output(levelgen_config_t* c, const char* suffix) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s%s", c->out_dir, c->name, suffix);
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "levelgen: cannot create %s: %s\n", path, strerror(errno));
+    }
+    return f;
+}
+
+static char random_command(levelgen_config_t* c, rng_t* rng, int* turns) {
+    static const char moves[] = {'W', 'A', 'S', 'D', 'W', 'A', 'S', 'D', 'R', 'T'};
+    *turns = 1 + (int)rng_bounded(rng, MAX_TURNS);
+    if ((rng_next(rng) / 4294967296.0) < c->charge_frequency) {
+        *turns = 1;
+        return 'C';
+    }
+    return moves[rng_bounded(rng, sizeof(moves))];
+}
+
+static int write_ghost(levelgen_config_t* c, int index, int cell, rng_t* rng) {
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), "_g%d.m", index);
+    FILE* f = open_output(c, suffix);
+    if (!f) return -1;
+
+    fprintf(f, "# Ghost %d (levelgen seed %llu)\n", index, (unsigned long long)c->seed);
+    fprintf(f, "PASSO %d\n", c->max_passo > 0 ? (int)rng_bounded(rng, c->max_passo + 1) : 0);
+    fprintf(f, "POS %d %d\n", cell / c->width, cell % c->width);
+    for (int m = 0; m < c->script_length; m++) {
+        int turns;
+        char command = random_command(c, rng, &turns);
+        if (turns > 1) fprintf(f, "%c %d\n", command, turns);
+        else fprintf(f, "%c\n", command);
+    }
+
+    long size = ftell(f);
+    fclose(f);
+    if (!c->force && size >= LEVEL_FILE_LIMIT) {
+        fprintf(stderr, "levelgen: ghost %d script is %ld bytes, the parser reads %d\n",
+                index, size, LEVEL_FILE_LIMIT - 1);
+    }
+    return 0;
+}
+
+static int generate(levelgen_config_t* c) {
+    int n_cells = c->width * c->height;
+    char* grid = malloc(n_cells);
+    char* used = calloc(n_cells, 1);
+    if (!grid || !used) {
+        free(grid);
+        free(used);
+        return -1;
+    }
+
+    rng_t rng;
+    rng_seed(&rng, c->seed);
+
+    int start = 0;
+    int n_free = build_grid(grid, c, &rng, &start);
+    if (n_free < c->ghosts + 2) {
+        fprintf(stderr, "levelgen: only %d reachable cells for the pacman, portal and %d ghosts;"
+                        " lower the wall density or the ghost count\n", n_free, c->ghosts);
+        free(grid);
+        free(used);
+        return -1;
+    }
+
+    used[start] = 1;
+    int portal = pick_free_cell(grid, used, n_cells, n_free - 1, &rng);
+    grid[portal] = '@';
+
+    int rc = 0;
+    FILE* lvl = open_output(c, ".lvl");
+    if (!lvl) rc = -1;
+
+    if (lvl) {
+        fprintf(lvl, "# %s - levelgen %dx%d walls=%.2f ghosts=%d seed=%llu\n", c->name, c->width,
+                c->height, c->wall_density, c->ghosts, (unsigned long long)c->seed);
+        fprintf(lvl, "DIM %d %d\nTEMPO %d\nPAC %s.p\n", c->width, c->height, c->tempo, c->name);
+        if (c->ghosts > 0) {
+            fprintf(lvl, "MON");
+            for (int g = 0; g < c->ghosts; g++) fprintf(lvl, " %s_g%d.m", c->name, g);
+            fprintf(lvl, "\n");
+        }
+        for (int y = 0; y < c->height; y++) {
+            fwrite(grid + (size_t)y * c->width, 1, c->width, lvl);
+            fputc('\n', lvl);
+        }
+        long size = ftell(lvl);
+        fclose(lvl);
+        if (size >= LEVEL_FILE_LIMIT) {
+            fprintf(stderr, "levelgen: %s.lvl is %ld bytes, the parser reads %d\n",
+                    c->name, size, LEVEL_FILE_LIMIT - 1);
+        }
+    }
+
+    FILE* pac = rc == 0 ? open_output(c, ".p") : NULL;
+    if (pac) {
+        fprintf(pac, "# Pacman (controlado pelo cliente)\nPASSO 0\nPOS %d %d\n",
+                start / c->width, start % c->width);
+        fclose(pac);
+    } else {
+        rc = -1;
+    }
+
+    // Uma casa livre é consumida pelo portal e outra pelo pacman
+    int remaining = n_free - 2;
+    for (int g = 0; g < c->ghosts && rc == 0; g++) {
+        int cell = pick_free_cell(grid, used, n_cells, remaining--, &rng);
+        if (cell < 0 || write_ghost(c, g, cell, &rng) != 0) rc = -1;
+    }
+
+    if (rc == 0) {
+        printf("%s/%s.lvl: %dx%d, %d reachable cells, %d ghosts x %d moves, seed %llu\n",
+               c->out_dir, c->name, c->width, c->height, n_free, c->ghosts, c->script_length,
+               (unsigned long long)c->seed);
+    }
+    free(grid);
+    free(used);
+    return rc;
+}
+
+// ========== MAIN ==========
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options] <out_dir>\n", program);
+    fprintf(stderr, "  -n name      level name, files <name>.lvl/.p/_gN.m (default stress)\n");
+    fprintf(stderr, "  -W width     board width (default 40)\n");
+    fprintf(stderr, "  -H height    board height (default 20)\n");
+    fprintf(stderr, "  -w density   interior wall probability 0..1 (default 0.10)\n");
+    fprintf(stderr, "  -g ghosts    ghost count (default 4)\n");
+    fprintf(stderr, "  -l length    commands per ghost script (default 10)\n");
+    fprintf(stderr, "  -c freq      probability of a C (charge) command 0..1 (default 0.10)\n");
+    fprintf(stderr, "  -p passo     maximum ghost PASSO (default 2)\n");
+    fprintf(stderr, "  -t tempo     TEMPO in ms (default 100)\n");
+    fprintf(stderr, "  -s seed      random seed; same options + seed = same files (default 1)\n");
+    fprintf(stderr, "  -f           keep sizes beyond the limits of the current parser\n");
+}
+
+int main(int argc, char* argv[]) {
+    levelgen_config_t config = {
+        .out_dir = NULL, .name = "stress", .width = 40, .height = 20, .wall_density = 0.10,
+        .ghosts = 4, .script_length = 10, .charge_frequency = 0.10, .max_passo = 2,
+        .tempo = 100, .seed = 1, .force = 0,
+    };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:W:H:w:g:l:c:p:t:s:f")) != -1) {
+        switch (opt) {
+            case 'n': config.name = optarg; break;
+            case 'W': config.width = atoi(optarg); break;
+            case 'H': config.height = atoi(optarg); break;
+            case 'w': config.wall_density = atof(optarg); break;
+            case 'g': config.ghosts = atoi(optarg); break;
+            case 'l': config.script_length = atoi(optarg); break;
+            case 'c': config.charge_frequency = atof(optarg); break;
+            case 'p': config.max_passo = atoi(optarg); break;
+            case 't': config.tempo = atoi(optarg); break;
+            case 's': config.seed = strtoull(optarg, NULL, 0); break;
+            case 'f': config.force = 1; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind != argc - 1 || config.width < 3 || config.height < 3 || config.ghosts < 0 ||
+        config.script_length < 1 || config.wall_density < 0 || config.wall_density >= 1 ||
+        config.charge_frequency < 0 || config.charge_frequency > 1 || config.max_passo < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    config.out_dir = argv[optind];
+
+    if (strlen(config.name) > LEVEL_NAME_LIMIT) {
+        fprintf(stderr, "levelgen: level name longer than %d characters\n", LEVEL_NAME_LIMIT);
+        return 1;
+    }
+    if (!config.force) {
+        apply_parser_limits(&config);
+    }
+
+    if (mkdir(config.out_dir, 0755) != 0 && errno != EEXIST) {
+        perror("levelgen: mkdir");
+        return 1;
+    }
+    return generate(&config) == 0 ? 0 : 1;
+}
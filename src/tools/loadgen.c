@@ -0,0 +1,392 @@
+#include "api.h"
+#include "protocol.h"
+#include "rng.h"
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CLOSE_GRACE_MS 5000            // Tempo para drenar os pipes no fim
+#define PENDING_INPUTS 64              // Jogadas por confirmar com instante de envio guardado
+
+typedef enum {
+    LG_IDLE = 0,                       // Sem ligação
+    LG_CONNECTING,                     // CONNECT enviado, à espera da resposta
+    LG_PLAYING,                        // A enviar jogadas e a receber frames
+    LG_CLOSING,                        // DISCONNECT enviado, a drenar até EOF
+} lg_phase_t;
+
+typedef struct {
+    int id;
+    lg_phase_t phase;
+    pacman_session_t* conn;            // Ligação não bloqueante da API do cliente
+    long long connect_start;           // ns
+    long long next_input;              // ns
+    long long sent_at[PENDING_INPUTS]; // ns do envio de cada seq (índice seq % PENDING_INPUTS)
+    unsigned int last_sent_seq;        // Última seq enviada (0 = nenhuma)
+    unsigned int last_acked_seq;       // Última seq refletida num frame
+    long long new_game_sent;           // ns do OP_CODE_NEW_GAME sem frame (0 = nenhum)
+    int script_pos;
+    rng_t rng;
+} lg_session_t;
+
+// Amostras de latência (ns)
+typedef struct {
+    long long* values;
+    int count;
+    int capacity;
+} samples_t;
+
+typedef struct {
+    samples_t connect;
+    samples_t input_to_frame;
+    samples_t new_game;
+    unsigned long long frames;
+    unsigned long long bytes;
+    unsigned long games;
+    unsigned long levels;              // Níveis passados sem o jogo acabar
+    unsigned long errors;
+} lg_stats_t;
+
+typedef struct {
+    int n_sessions;
+    int first_id;
+    double rate;                       // Jogadas por segundo por sessão
+    double duration;                   // Segundos
+    const char* script;                // NULL = direções aleatórias
+    uint64_t seed;
+    const char* register_pipe;
+    int keep_connection;               // 1 = novo jogo com OP_CODE_NEW_GAME em vez de voltar a ligar
+} lg_config_t;
+
+static lg_stats_t stats;
+static const char* register_pipe = NULL;
+static int keep_connection = 0;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void samples_add(samples_t* samples, long long value) {
+    if (samples->count == samples->capacity) {
+        int capacity = samples->capacity ? samples->capacity * 2 : 1024;
+        long long* grown = realloc(samples->values, capacity * sizeof(long long));
+        if (!grown) return;
+        samples->values = grown;
+        samples->capacity = capacity;
+    }
+    samples->values[samples->count++] = value;
+}
+
+static int compare_ll(const void* a, const void* b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+static void print_percentiles(const char* name, samples_t* samples) {
+    if (samples->count == 0) {
+        printf("%s (ms): no samples\n", name);
+        return;
+    }
+    qsort(samples->values, samples->count, sizeof(long long), compare_ll);
+    int n = samples->count;
+    printf("%s (ms): n=%d p50=%.2f p90=%.2f p99=%.2f max=%.2f\n", name, n,
+           samples->values[(n - 1) * 50 / 100] / 1e6, samples->values[(n - 1) * 90 / 100] / 1e6,
+           samples->values[(n - 1) * 99 / 100] / 1e6, samples->values[n - 1] / 1e6);
+}
+
+// ========== LIGAÇÃO ==========
+
+static void close_session(lg_session_t* s) {
+    pacman_session_close(s->conn);
+    s->conn = NULL;
+    s->phase = LG_IDLE;
+}
+
+/* Cria os FIFOs e envia CONNECT com pacman_session_open: nada espera pelo
+servidor, por isso uma sessão em fila não atrasa as outras. */
+static int start_session(lg_session_t* s) {
+    char req_path[MAX_PIPE_PATH_LENGTH];
+    char notif_path[MAX_PIPE_PATH_LENGTH];
+    snprintf(req_path, sizeof(req_path), "/tmp/%d_request", s->id);
+    snprintf(notif_path, sizeof(notif_path), "/tmp/%d_notification", s->id);
+
+    s->connect_start = now_ns();
+    s->conn = pacman_session_open(req_path, notif_path, register_pipe);
+    if (!s->conn) {
+        return -1;
+    }
+
+    s->phase = LG_CONNECTING;
+    s->last_sent_seq = 0;
+    s->last_acked_seq = 0;
+    s->new_game_sent = 0;
+    return 0;
+}
+
+/* Termina o jogo do lado do cliente e passa a drenar até o servidor fechar. */
+static void disconnect_session(lg_session_t* s) {
+    if (s->phase == LG_CONNECTING) {
+        // Ainda não servida: remover os FIFOs faz o servidor desistir dela
+        close_session(s);
+        return;
+    }
+    if (pacman_session_disconnect(s->conn) != 0) {
+        stats.errors++;
+    }
+    s->phase = LG_CLOSING;
+}
+
+/* Pede outro jogo na mesma ligação (-k). Devolve -1 se o pedido falhou. */
+static int restart_game(lg_session_t* s) {
+    if (pacman_session_new_game(s->conn, NEW_GAME_RESTART) != 0) {
+        stats.errors++;
+        return -1;
+    }
+    // Medido no envio: o now do ciclo é anterior à drenagem em que o jogo acabou
+    s->new_game_sent = now_ns();
+    // As jogadas do jogo anterior já não vão ser confirmadas
+    s->last_acked_seq = s->last_sent_seq;
+    return 0;
+}
+
+// ========== RECEÇÃO ==========
+
+/* Consome um frame completo. Devolve 1 se o jogo acabou. */
+static int on_frame(lg_session_t* s, const Board* board, long long now) {
+    stats.frames++;
+    stats.bytes += (board->has_seq ? 33 : 25) + (unsigned long long)board->width * board->height;
+
+    // Amostrar cada jogada no primeiro frame que a reflete (last_seq a cobre)
+    if (board->has_seq) {
+        unsigned int acked = board->last_seq;
+        if (acked > s->last_sent_seq) acked = s->last_sent_seq;
+        for (unsigned int seq = s->last_acked_seq + 1; seq <= acked && acked > s->last_acked_seq; seq++) {
+            // Jogadas mais antigas do que o anel já foram sobrescritas
+            if (s->last_sent_seq - seq < PENDING_INPUTS) {
+                samples_add(&stats.input_to_frame, now - s->sent_at[seq % PENDING_INPUTS]);
+            }
+        }
+        if (acked > s->last_acked_seq) s->last_acked_seq = acked;
+    }
+    // Vitória sem game_over: o servidor já passou ao nível seguinte
+    if (board->victory && !board->game_over) {
+        stats.levels++;
+    }
+    return board->game_over;
+}
+
+/* Trata tudo o que está disponível. Devolve -1 se a sessão terminou (EOF, erro,
+ou fim do jogo sem -k). */
+static int on_readable(lg_session_t* s, long long now) {
+    while (1) {
+        const Board* board;
+        switch (pacman_try_receive(s->conn, &board)) {
+            case PACMAN_EVENT_NONE:
+                return 0;
+            case PACMAN_EVENT_CLOSED:
+                return -1;
+            case PACMAN_EVENT_CONNECTED:
+                samples_add(&stats.connect, now - s->connect_start);
+                s->phase = LG_PLAYING;
+                s->next_input = now;
+                break;
+            case PACMAN_EVENT_FRAME:
+                // A fechar: só drenar até EOF
+                if (s->phase != LG_PLAYING) {
+                    break;
+                }
+                if (s->new_game_sent) {
+                    // Pode chegar na mesma drenagem em que o pedido foi enviado
+                    samples_add(&stats.new_game, now_ns() - s->new_game_sent);
+                    s->new_game_sent = 0;
+                }
+                if (on_frame(s, board, now)) {
+                    stats.games++;
+                    if (keep_connection && restart_game(s) == 0) {
+                        break;
+                    }
+                    return -1;
+                }
+                break;
+        }
+    }
+}
+
+// ========== ENVIO ==========
+
+static void send_input(lg_session_t* s, lg_config_t* config, long long now) {
+    char command;
+    if (config->script) {
+        command = config->script[s->script_pos++ % strlen(config->script)];
+    } else {
+        static const char directions[] = {'W', 'A', 'S', 'D'};
+        command = directions[rng_bounded(&s->rng, 4)];
+    }
+
+    unsigned int seq = pacman_session_play_seq(s->conn, command);
+    if (seq == 0) {
+        stats.errors++;
+        return;
+    }
+    s->sent_at[seq % PENDING_INPUTS] = now;
+    s->last_sent_seq = seq;
+}
+
+// ========== MAIN ==========
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options] <register_pipe>\n", program);
+    fprintf(stderr, "  -n sessions   concurrent sessions (default 10)\n");
+    fprintf(stderr, "  -r rate       PLAY commands per second per session (default 5)\n");
+    fprintf(stderr, "  -d seconds    test duration (default 10)\n");
+    fprintf(stderr, "  -c commands   scripted command string, repeated (default random WASD)\n");
+    fprintf(stderr, "  -i first_id   client id of the first session (default 1000)\n");
+    fprintf(stderr, "  -S seed       seed for the random commands (default 1)\n");
+    fprintf(stderr, "  -k            keep the connection: start each new game with NEW_GAME\n");
+}
+
+int main(int argc, char* argv[]) {
+    lg_config_t config = {
+        .n_sessions = 10, .first_id = 1000, .rate = 5.0, .duration = 10.0,
+        .script = NULL, .seed = 1, .register_pipe = NULL, .keep_connection = 0,
+    };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:d:c:i:S:k")) != -1) {
+        switch (opt) {
+            case 'n': config.n_sessions = atoi(optarg); break;
+            case 'r': config.rate = atof(optarg); break;
+            case 'd': config.duration = atof(optarg); break;
+            case 'c': config.script = optarg; break;
+            case 'i': config.first_id = atoi(optarg); break;
+            case 'S': config.seed = strtoull(optarg, NULL, 0); break;
+            case 'k': config.keep_connection = 1; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind != argc - 1 || config.n_sessions <= 0 || config.rate <= 0 ||
+        (config.script && !*config.script)) {
+        usage(argv[0]);
+        return 1;
+    }
+    config.register_pipe = argv[optind];
+    register_pipe = config.register_pipe;
+    keep_connection = config.keep_connection;
+
+    // O servidor pode fechar um pipe de pedidos a meio de uma escrita
+    signal(SIGPIPE, SIG_IGN);
+
+    lg_session_t* sessions = calloc(config.n_sessions, sizeof(lg_session_t));
+    struct pollfd* fds = calloc(config.n_sessions, sizeof(struct pollfd));
+    int* fd_session = calloc(config.n_sessions, sizeof(int));
+    if (!sessions || !fds || !fd_session) {
+        perror("loadgen: calloc");
+        return 1;
+    }
+
+    long long period = (long long)(1e9 / config.rate);
+    long long start = now_ns();
+    long long stop_at = start + (long long)(config.duration * 1e9);
+    long long give_up_at = stop_at + CLOSE_GRACE_MS * 1000000LL;
+    int stopping = 0;
+
+    for (int i = 0; i < config.n_sessions; i++) {
+        sessions[i].id = config.first_id + i;
+        rng_seed(&sessions[i].rng, config.seed + i);
+        if (start_session(&sessions[i]) != 0) {
+            stats.errors++;
+        }
+    }
+
+    while (1) {
+        long long now = now_ns();
+
+        if (!stopping && now >= stop_at) {
+            stopping = 1;
+            for (int i = 0; i < config.n_sessions; i++) {
+                if (sessions[i].phase != LG_IDLE) disconnect_session(&sessions[i]);
+            }
+        }
+
+        // Jogadas em atraso e próximo prazo de envio
+        long long next_deadline = now + 100 * 1000000LL;
+        int active = 0;
+        int nfds = 0;
+        for (int i = 0; i < config.n_sessions; i++) {
+            lg_session_t* s = &sessions[i];
+            if (s->phase == LG_PLAYING) {
+                if (s->next_input <= now) {
+                    send_input(s, &config, now);
+                    s->next_input += period;
+                    if (s->next_input < now) s->next_input = now + period;
+                }
+                if (s->next_input < next_deadline) next_deadline = s->next_input;
+            }
+            if (s->phase != LG_IDLE) {
+                active++;
+                fds[nfds].fd = pacman_session_fd(s->conn);
+                fds[nfds].events = POLLIN;
+                fd_session[nfds] = i;
+                nfds++;
+            }
+        }
+
+        if (stopping && (active == 0 || now >= give_up_at)) {
+            break;
+        }
+
+        int timeout_ms = (int)((next_deadline - now) / 1000000LL);
+        if (timeout_ms < 0) timeout_ms = 0;
+        if (poll(fds, nfds, timeout_ms) < 0 && errno != EINTR) {
+            perror("loadgen: poll");
+            break;
+        }
+
+        now = now_ns();
+        for (int f = 0; f < nfds; f++) {
+            if (!(fds[f].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            lg_session_t* s = &sessions[fd_session[f]];
+            if (on_readable(s, now) == 0) continue;
+
+            if (s->phase == LG_PLAYING) {
+                // Jogo acabou: libertar o servidor e, ainda dentro do teste, voltar a ligar
+                disconnect_session(s);
+            } else {
+                close_session(s);
+                if (!stopping && start_session(s) != 0) {
+                    stats.errors++;
+                }
+            }
+        }
+    }
+
+    double elapsed = (now_ns() - start) / 1e9;
+    for (int i = 0; i < config.n_sessions; i++) {
+        if (sessions[i].phase != LG_IDLE) close_session(&sessions[i]);
+    }
+
+    printf("loadgen: %d sessions, %.1f s, %lu games finished, %lu levels cleared, %lu errors\n",
+           config.n_sessions, elapsed, stats.games, stats.levels, stats.errors);
+    printf("frames: %llu (%.1f/s), bytes: %llu (%.1f/s)\n", stats.frames,
+           stats.frames / config.duration, stats.bytes, stats.bytes / config.duration);
+    print_percentiles("connect latency", &stats.connect);
+    print_percentiles("input-to-frame latency", &stats.input_to_frame);
+    if (config.keep_connection) {
+        print_percentiles("new game latency", &stats.new_game);
+    }
+
+    free(stats.connect.values);
+    free(stats.input_to_frame.values);
+    free(stats.new_game.values);
+    free(sessions);
+    free(fds);
+    free(fd_session);
+    return 0;
+}
@@ -0,0 +1,304 @@
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+// Linha já formatada
+typedef struct {
+    uint64_t timestamp;
+    unsigned long order;               // Ordem no ficheiro (desempate da ordenação)
+    int level;
+    int thread;
+    char* text;
+} entry_t;
+
+typedef struct {
+    entry_t* entries;
+    size_t n_entries;
+    size_t capacity;
+} entry_list_t;
+
+// Formatos de um ficheiro (id -> texto); cada ficheiro rodado tem a sua tabela
+typedef struct {
+    char** formats;
+    uint32_t n_formats;
+} format_table_t;
+
+static const char* level_names[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+
+static void add_entry(entry_list_t* list, uint64_t timestamp, int level, int thread, char* text) {
+    if (list->n_entries == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 1024;
+        list->entries = realloc(list->entries, list->capacity * sizeof(entry_t));
+    }
+    entry_t* e = &list->entries[list->n_entries];
+    e->timestamp = timestamp;
+    e->order = list->n_entries;
+    e->level = level;
+    e->thread = thread;
+    e->text = text;
+    list->n_entries++;
+}
+
+static int compare_entries(const void* a, const void* b) {
+    const entry_t* ea = (const entry_t*)a;
+    const entry_t* eb = (const entry_t*)b;
+    if (ea->timestamp != eb->timestamp) return ea->timestamp < eb->timestamp ? -1 : 1;
+    return ea->order < eb->order ? -1 : 1;
+}
+
+// ========== FORMATAÇÃO ==========
+
+/* Formata um valor com a conversão original (spec copiada do formato). */
+static void format_value(FILE* out, const char* spec, log_spec_t* s, const unsigned char* value) {
+    int64_t i;
+    uint64_t u;
+    double d;
+
+    switch (s->arg) {
+        case LOG_ARG_INT:
+            memcpy(&i, value, 8);
+            switch (s->modifier) {
+                case LOG_MOD_L: fprintf(out, spec, (long)i); break;
+                case LOG_MOD_LL: fprintf(out, spec, (long long)i); break;
+                case LOG_MOD_Z: fprintf(out, spec, (ssize_t)i); break;
+                case LOG_MOD_J: fprintf(out, spec, (intmax_t)i); break;
+                case LOG_MOD_T: fprintf(out, spec, (ptrdiff_t)i); break;
+                default: fprintf(out, spec, (int)i); break;
+            }
+            break;
+        case LOG_ARG_UINT:
+            memcpy(&u, value, 8);
+            switch (s->modifier) {
+                case LOG_MOD_L: fprintf(out, spec, (unsigned long)u); break;
+                case LOG_MOD_LL: fprintf(out, spec, (unsigned long long)u); break;
+                case LOG_MOD_Z: fprintf(out, spec, (size_t)u); break;
+                case LOG_MOD_J: fprintf(out, spec, (uintmax_t)u); break;
+                case LOG_MOD_T: fprintf(out, spec, (ptrdiff_t)u); break;
+                default: fprintf(out, spec, (unsigned int)u); break;
+            }
+            break;
+        case LOG_ARG_DOUBLE:
+            memcpy(&d, value, 8);
+            if (s->modifier == LOG_MOD_LONG_DOUBLE) fprintf(out, spec, (long double)d);
+            else fprintf(out, spec, d);
+            break;
+        case LOG_ARG_POINTER:
+            memcpy(&u, value, 8);
+            fprintf(out, spec, (void*)(uintptr_t)u);
+            break;
+        default:
+            break;
+    }
+}
+
+/* Reconstrói a mensagem a partir do formato e dos argumentos gravados. */
+static char* render_message(const char* format, const unsigned char* args, size_t args_size) {
+    char* text = NULL;
+    size_t text_size = 0;
+    FILE* out = open_memstream(&text, &text_size);
+    size_t pos = 0;
+
+    for (const char* p = format; *p; p++) {
+        if (*p != '%') {
+            fputc(*p, out);
+            continue;
+        }
+        log_spec_t spec;
+        if (!log_parse_spec(p, &spec)) {
+            fputs(p, out);  // O servidor deixou de gravar argumentos aqui
+            break;
+        }
+        char spec_text[32];
+        int len = spec.length < (int)sizeof(spec_text) ? spec.length : (int)sizeof(spec_text) - 1;
+        memcpy(spec_text, p, len);
+        spec_text[len] = '\0';
+        p += spec.length - 1;
+
+        if (spec.arg == LOG_ARG_NONE) {
+            fputc('%', out);
+            continue;
+        }
+        if (pos >= args_size || args[pos] != spec.arg) {
+            fputs("<?>", out);  // Argumento truncado ou em falta
+            continue;
+        }
+        pos++;
+        if (spec.arg == LOG_ARG_STRING) {
+            uint16_t slen;
+            if (pos + 2 > args_size) break;
+            memcpy(&slen, args + pos, 2);
+            pos += 2;
+            if (pos + slen > args_size) break;
+            char* s = strndup((const char*)args + pos, slen);
+            fprintf(out, spec_text, s);
+            free(s);
+            pos += slen;
+        } else {
+            if (pos + 8 > args_size) break;
+            format_value(out, spec_text, &spec, args + pos);
+            pos += 8;
+        }
+    }
+
+    fclose(out);
+    // As mensagens trazem o próprio '\n'; a linha é terminada na impressão
+    while (text_size > 0 && text[text_size - 1] == '\n') text[--text_size] = '\0';
+    return text;
+}
+
+// ========== LEITURA ==========
+
+static unsigned char* read_file(const char* path, size_t* size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char* data = malloc(length > 0 ? length : 1);
+    *size = fread(data, 1, length, f);
+    fclose(f);
+    return data;
+}
+
+/* Descodifica um ficheiro para list. Devolve 0, ou -1 se não for um log binário;
+um registo incompleto no fim (servidor terminado a meio da escrita) é ignorado. */
+static int decode_file(const char* path, entry_list_t* list, int min_level) {
+    size_t size;
+    unsigned char* data = read_file(path, &size);
+    if (!data) {
+        perror(path);
+        return -1;
+    }
+    if (size < 5 || memcmp(data, LOG_MAGIC, 4) != 0 || data[4] != LOG_VERSION) {
+        fprintf(stderr, "%s: not a binary log (version %d)\n", path, LOG_VERSION);
+        free(data);
+        return -1;
+    }
+
+    format_table_t table = {NULL, 0};
+    uint64_t last_timestamp = 0;
+    size_t pos = 5;
+    while (pos < size) {
+        unsigned char tag = data[pos];
+        if (tag == LOG_REC_FORMAT) {
+            uint32_t id;
+            uint16_t len;
+            if (pos + 7 > size) break;
+            memcpy(&id, data + pos + 1, 4);
+            memcpy(&len, data + pos + 5, 2);
+            if (pos + 7 + len > size) break;
+            if (id >= table.n_formats) {
+                table.formats = realloc(table.formats, (id + 1) * sizeof(char*));
+                for (uint32_t i = table.n_formats; i <= id; i++) table.formats[i] = NULL;
+                table.n_formats = id + 1;
+            }
+            free(table.formats[id]);
+            table.formats[id] = strndup((const char*)data + pos + 7, len);
+            pos += 7 + len;
+        } else if (tag == LOG_REC_MESSAGE) {
+            uint32_t id;
+            uint8_t level;
+            uint16_t thread, args_size;
+            uint64_t timestamp;
+            if (pos + 18 > size) break;
+            memcpy(&id, data + pos + 1, 4);
+            level = data[pos + 5];
+            memcpy(&thread, data + pos + 6, 2);
+            memcpy(&timestamp, data + pos + 8, 8);
+            memcpy(&args_size, data + pos + 16, 2);
+            if (pos + 18 + args_size > size) break;
+            last_timestamp = timestamp;
+            if (level >= min_level) {
+                const char* format = id < table.n_formats && table.formats[id] ? table.formats[id]
+                                                                                : "<unknown format>";
+                add_entry(list, timestamp, level, thread,
+                          render_message(format, data + pos + 18, args_size));
+            }
+            pos += 18 + args_size;
+        } else if (tag == LOG_REC_DROPPED) {
+            uint16_t thread;
+            uint32_t count;
+            if (pos + 7 > size) break;
+            memcpy(&thread, data + pos + 1, 2);
+            memcpy(&count, data + pos + 3, 4);
+            char* text = NULL;
+            size_t text_size = 0;
+            FILE* out = open_memstream(&text, &text_size);
+            fprintf(out, "<%u records dropped: ring full>", count);
+            fclose(out);
+            add_entry(list, last_timestamp, LOG_LEVEL_WARN, thread, text);
+            pos += 7;
+        } else {
+            fprintf(stderr, "%s: corrupt record at offset %zu\n", path, pos);
+            break;
+        }
+    }
+
+    for (uint32_t i = 0; i < table.n_formats; i++) free(table.formats[i]);
+    free(table.formats);
+    free(data);
+    return 0;
+}
+
+// ========== MAIN ==========
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [-r] [-l level] <log files...>\n", program);
+    fprintf(stderr, "  Decodes the server's binary debug log. Pass rotated files oldest first,\n");
+    fprintf(stderr, "  e.g. debug.log.3 debug.log.2 debug.log.1 debug.log\n");
+    fprintf(stderr, "  -r         keep file order (default: sort by timestamp across threads)\n");
+    fprintf(stderr, "  -l level   minimum level: 0=debug 1=info 2=warn 3=error\n");
+}
+
+int main(int argc, char* argv[]) {
+    int raw = 0;
+    int min_level = LOG_LEVEL_DEBUG;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "rl:")) != -1) {
+        switch (opt) {
+            case 'r': raw = 1; break;
+            case 'l': min_level = atoi(optarg); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    entry_list_t list = {NULL, 0, 0};
+    int rc = 0;
+    for (int i = optind; i < argc; i++) {
+        if (decode_file(argv[i], &list, min_level) != 0) {
+            rc = 1;
+        }
+    }
+
+    // A thread de escrita esvazia um anel de cada vez: ordenar repõe a ordem temporal
+    if (!raw) {
+        qsort(list.entries, list.n_entries, sizeof(entry_t), compare_entries);
+    }
+
+    for (size_t i = 0; i < list.n_entries; i++) {
+        entry_t* e = &list.entries[i];
+        time_t seconds = (time_t)(e->timestamp / 1000000000ULL);
+        struct tm tm;
+        localtime_r(&seconds, &tm);
+        char when[32];
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &tm);
+        printf("%s.%06lu %-5s t%-3d %s\n", when, (unsigned long)(e->timestamp % 1000000000ULL / 1000),
+               e->level >= 0 && e->level <= LOG_LEVEL_ERROR ? level_names[e->level] : "?",
+               e->thread, e->text);
+        free(e->text);
+    }
+    free(list.entries);
+    return rc;
+}
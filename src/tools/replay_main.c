@@ -0,0 +1,223 @@
+#include "board.h"
+#include "replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Níveis já parseados (uma gravação de cada vez usa sempre os mesmos)
+typedef struct {
+    level_data_t data[MAX_LEVELS];
+    int n_levels;
+} level_cache_t;
+
+static level_data_t* cached_level(level_cache_t* cache, char* levels_directory, char* level_name) {
+    for (int i = 0; i < cache->n_levels; i++) {
+        if (strcmp(cache->data[i].level_name, level_name) == 0) {
+            return &cache->data[i];
+        }
+    }
+    if (cache->n_levels == MAX_LEVELS) {
+        return NULL;
+    }
+    level_data_t* level = &cache->data[cache->n_levels];
+    if (parse_level_file(levels_directory, level_name, level) != 0) {
+        return NULL;
+    }
+    cache->n_levels++;
+    return level;
+}
+
+static const char* outcome_name(int outcome) {
+    switch (outcome) {
+        case REPLAY_VICTORY: return "victory";
+        case REPLAY_DEAD: return "dead";
+        case REPLAY_DISCONNECTED: return "disconnected";
+        default: return "unknown";
+    }
+}
+
+static double elapsed_seconds(struct timespec* start, struct timespec* end) {
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [-q] [-n repeat] [-s tick [-l]] <levels_dir> <recording.pmr>...\n", program);
+    fprintf(stderr, "  -q         only print the totals\n");
+    fprintf(stderr, "  -n repeat  replay every recording this many times (benchmarking)\n");
+    fprintf(stderr, "  -s tick    print the game state right before tick (seeks via keyframes)\n");
+    fprintf(stderr, "  -l         with -s, ignore the keyframes and replay from tick 0\n");
+}
+
+static void print_state(replay_player_t* player) {
+    board_t* board = &player->board;
+    pacman_t* pac = &board->pacmans[0];
+
+    printf("  tick=%lu finished=%d outcome=%s pacman=(%d,%d) alive=%d points=%d\n",
+           player->tick, player->finished, outcome_name(player->outcome),
+           pac->pos_x, pac->pos_y, pac->alive, pac->points);
+    for (int g = 0; g < board->n_ghosts; g++) {
+        printf("  ghost %d=(%d,%d) charged=%d\n", g, board->ghosts[g].pos_x,
+               board->ghosts[g].pos_y, board->ghosts[g].charged);
+    }
+    for (int y = 0; y < board->height; y++) {
+        printf("  ");
+        for (int x = 0; x < board->width; x++) {
+            board_pos_t* cell = &board->board[y * board->width + x];
+            char c = cell->content;
+            if (c == ' ' && cell->has_portal) c = '@';
+            else if (c == ' ' && cell->has_dot) c = '.';
+            putchar(c);
+        }
+        putchar('\n');
+    }
+}
+
+/* Modo -s: salta para um tick e mostra o estado e o custo do salto. */
+static int seek_recording(replay_t* replay, level_data_t* level, char* levels_directory,
+                          const char* path, unsigned long tick, int linear) {
+    if (linear) {
+        replay->n_keyframes = 0;  // Força o replay desde o tick 0
+    }
+
+    replay_player_t player;
+    if (replay_player_init(&player, replay, level, levels_directory) != 0) {
+        fprintf(stderr, "%s: cannot build the board\n", path);
+        return -1;
+    }
+
+    struct timespec start, end;
+    unsigned long keyframe_tick = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int rc = replay_seek(&player, tick, &keyframe_tick);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (rc != 0) {
+        fprintf(stderr, "%s: corrupt record stream\n", path);
+    } else {
+        printf("%s: seek to %lu from keyframe %lu (%d keyframes) in %.3f ms, %lu inputs and %lu ghost moves replayed\n",
+               path, tick, keyframe_tick, replay->n_keyframes, elapsed_seconds(&start, &end) * 1e3,
+               player.inputs, player.ghost_moves);
+        print_state(&player);
+    }
+    replay_player_destroy(&player);
+    return rc;
+}
+
+int main(int argc, char* argv[]) {
+    int quiet = 0;
+    int repeat = 1;
+    int seek = 0, linear = 0;
+    unsigned long seek_tick = 0;
+    int arg = 1;
+
+    while (arg < argc && argv[arg][0] == '-') {
+        if (strcmp(argv[arg], "-q") == 0) {
+            quiet = 1;
+            arg++;
+        } else if (strcmp(argv[arg], "-n") == 0 && arg + 1 < argc) {
+            repeat = atoi(argv[arg + 1]);
+            arg += 2;
+        } else if (strcmp(argv[arg], "-s") == 0 && arg + 1 < argc) {
+            seek = 1;
+            seek_tick = strtoul(argv[arg + 1], NULL, 10);
+            arg += 2;
+        } else if (strcmp(argv[arg], "-l") == 0) {
+            linear = 1;
+            arg++;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (argc - arg < 2 || repeat <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    char* levels_directory = argv[arg++];
+    level_cache_t* cache = calloc(1, sizeof(level_cache_t));
+    if (!cache) {
+        perror("calloc");
+        return 1;
+    }
+
+    unsigned long games = 0, ticks = 0, inputs = 0, ghost_moves = 0;
+    int failures = 0, mismatches = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (; arg < argc; arg++) {
+        replay_t replay;
+        if (replay_load(&replay, argv[arg]) != 0) {
+            fprintf(stderr, "%s: not a valid recording\n", argv[arg]);
+            failures++;
+            continue;
+        }
+
+        level_data_t* level = cached_level(cache, levels_directory, replay.level_name);
+        if (!level) {
+            fprintf(stderr, "%s: cannot load level %s\n", argv[arg], replay.level_name);
+            replay_free(&replay);
+            failures++;
+            continue;
+        }
+
+        if (seek) {
+            if (seek_recording(&replay, level, levels_directory, argv[arg], seek_tick, linear) != 0) {
+                failures++;
+            }
+            replay_free(&replay);
+            continue;
+        }
+
+        for (int r = 0; r < repeat; r++) {
+            replay_result_t result;
+            if (replay_run(&replay, level, levels_directory, &result) != 0) {
+                fprintf(stderr, "%s: corrupt record stream\n", argv[arg]);
+                failures++;
+                break;
+            }
+            games++;
+            ticks += result.ticks;
+            inputs += result.inputs;
+            ghost_moves += result.ghost_moves;
+
+            int match = !result.has_end ||
+                        (result.outcome == result.expected_outcome &&
+                         result.points == result.expected_points &&
+                         result.ticks == result.expected_ticks);
+            if (!match) mismatches++;
+
+            if (!quiet && r == 0) {
+                printf("%s: level=%s (#%d, from %d points) seed=%llu ticks=%lu inputs=%lu outcome=%s points=%d%s\n",
+                       argv[arg], replay.level_name, replay.level_index + 1, replay.start_points,
+                       (unsigned long long)replay.seed,
+                       result.ticks, result.inputs, outcome_name(result.outcome), result.points,
+                       !result.has_end ? " (truncated)" : match ? "" : " MISMATCH");
+                if (!match) {
+                    printf("  recorded: ticks=%lu outcome=%s points=%d\n", result.expected_ticks,
+                           outcome_name(result.expected_outcome), result.expected_points);
+                }
+            }
+        }
+        replay_free(&replay);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (seek) {
+        free(cache);
+        return failures ? 1 : 0;
+    }
+    double seconds = elapsed_seconds(&start, &end);
+
+    printf("%lu games, %lu ticks, %lu inputs, %lu ghost moves in %.3f s", games, ticks, inputs,
+           ghost_moves, seconds);
+    if (seconds > 0) {
+        printf(" (%.0f ticks/s, %.0f games/s)", ticks / seconds, games / seconds);
+    }
+    printf("\n%d mismatches, %d failures\n", mismatches, failures);
+
+    free(cache);
+    return (mismatches || failures) ? 1 : 0;
+}